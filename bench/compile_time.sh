@@ -0,0 +1,47 @@
+#!/bin/sh
+# Measures the per translation unit compile time of a typical test file with tester.h and tester_slim.h
+# Usage: bench/compile_time.sh [files] [checks per file], with CXX and CXXFLAGS taken from the environment
+set -e
+
+FILES=${1:-20}
+CHECKS=${2:-50}
+CXX=${CXX:-c++}
+CXXFLAGS=${CXXFLAGS:--std=c++17 -O1}
+INCLUDE=$(cd "$(dirname "$0")/../include" && pwd)
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+generate()
+{
+	echo "#include \"$1\""
+	echo '#include <string>'
+	echo '#include <vector>'
+	echo "TEST_CASE(\"case $2\")"
+	echo '{'
+	echo '	int i = 1; double d = 0.5; std::string s = "text"; std::vector<int> v = { 1, 2, 3 };'
+	n=0
+	while [ $n -lt "$CHECKS" ]; do
+		echo "	tester::Subcase(\"subcase $n\") << [&] { CHECK(i + $n == $n + 1); CHECK(d < $n.5); CHECK(s != \"$n\"); CHECK(v.size() == 3); };"
+		n=$((n + 1))
+	done
+	echo '};'
+}
+
+measure()
+{
+	mkdir -p "$WORK/$2"
+	i=0
+	while [ $i -lt "$FILES" ]; do
+		generate "$1" $i > "$WORK/$2/test$i.cpp"
+		i=$((i + 1))
+	done
+	start=$(date +%s.%N)
+	for f in "$WORK/$2"/*.cpp; do
+		$CXX $CXXFLAGS -I"$INCLUDE" -c "$f" -o "$f.o"
+	done
+	end=$(date +%s.%N)
+	echo "$2: $(awk "BEGIN { printf \"%.3f\", ($end - $start) / $FILES }")s per file"
+}
+
+measure tester_with_macros.h full
+measure tester_slim_with_macros.h slim
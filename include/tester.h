@@ -1,12 +1,40 @@
 #pragma once
 
+#include "tester_case_entry.h"
+
 #include <sstream>
 #include <typeindex>
+#include <typeinfo>
 #include <functional>
+#include <iterator>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <cstdint>
+#include <chrono>
 
 namespace tester
 {
 	using Procedure = std::function<void()>;
+
+	// Non-owning reference to a callable, so entering subcases does not build a std::function
+	class ProcedureRef
+	{
+		void* _callable;
+		void (*_call)(void*);
+	public:
+		template <class Proc, class = std::enable_if_t<!std::is_same_v<std::decay_t<Proc>, ProcedureRef>>>
+		ProcedureRef(Proc&& proc) 
+			: _callable(const_cast<void*>(static_cast<const void*>(std::addressof(proc))))
+			, _call([](void* callable) { (*static_cast<std::remove_reference_t<Proc>*>(callable))(); })
+		{ }
+
+		void operator()() const { _call(_callable); }
+	};
 	using Report = std::ostringstream;
 
 	extern Report report;
@@ -37,7 +65,7 @@ namespace tester
 	};
 	template <class T>
 	EnsurePrintable<T> print(const T& value) { return { value }; }
-	inline const char* print(const type_info& type) { return type.name(); }
+	inline const char* print(const std::type_info& type) { return type.name(); }
 	inline const char* print(const std::type_index& type) { return type.name(); }
 
 	template <class T>
@@ -99,7 +127,7 @@ namespace tester
 	template <> struct Applier<Op::SG> { template <typename A, typename B> static bool apply(const A& a, const B& b) { return bool(a >  b); } };
 
 	template <class T>
-	struct Magnitude { double operator()(const T& x) const { return double(abs(x)); } };
+	struct Magnitude { double operator()(const T& x) const { using std::abs; return double(abs(x)); } };
 	template <class T>
 	double magnitude(const T& x) { return Magnitude<T>{}(x); }
 
@@ -219,10 +247,6 @@ namespace tester
 	result::Type<T> operator<<(const Split&, T&& value) { return { std::forward<T>(value) }; }
 
 
-	bool report_failure();
-
-
-
 	class Assertion
 	{
 	public:
@@ -230,22 +254,26 @@ namespace tester
 		unsigned    const line;
 		const char* const expr;
 
-		static void increaseCount();
+		// Also records the site as the last one reached, for timeout reports
+		void increaseCount() const;
 	};
 
+	// Counts a failure of the assertion site, returns true the first time the site fails in the current subcase
+	bool report_failure(const Assertion& info);
+
 	std::ostream& operator<<(std::ostream& out, const Assertion& test);
 
 	template <class Proc>
 	void check_noexcept(const Assertion& info, const Proc& test)
 	{
-		Assertion::increaseCount();
+		info.increaseCount();
 		try
 		{
 			test();
 		}
 		catch (std::exception& e)
 		{
-			if (report_failure()) 
+			if (report_failure(info)) 
 				Subreport{} <<
 				info << "failed:\n" <<
 				"    threw " << (typeid(e).name() + 6) << " with message:\n" <<
@@ -253,7 +281,7 @@ namespace tester
 		}
 		catch (...)
 		{
-			if (report_failure())
+			if (report_failure(info))
 				Subreport{} <<
 				info << "failed:\n" <<
 				"    threw unknown exception\n";
@@ -264,10 +292,10 @@ namespace tester
 	template <class Result>
 	void check(const Assertion& info, const Result& result)
 	{
-		Assertion::increaseCount();
+		info.increaseCount();
 		if (!result)
 		{
-			if (report_failure())
+			if (report_failure(info))
 				Subreport{} <<
 				info << "failed: expands to\n" <<
 				"    " << result << "\n";
@@ -277,10 +305,10 @@ namespace tester
 	template <class First, class Last, Op OP>
 	void check_approx(const Assertion& info, const result::Type<Last, result::TypeOp<First, OP>>& result)
 	{
-		Assertion::increaseCount();
+		info.increaseCount();
 		if (!result.approximate())
 		{
-			if (report_failure())
+			if (report_failure(info))
 			{
 				Subreport{}
 					<< info << "failed: expands to\n"
@@ -291,6 +319,53 @@ namespace tester
 		}
 	}
 
+	// Allocation counts of the calling thread
+	// Only updated when src/tester_alloc.cpp, which replaces operator new and delete, is linked in
+	struct AllocationCounters
+	{
+		size_t allocations;
+		size_t deallocations;
+		size_t bytes;
+		ptrdiff_t live;
+		ptrdiff_t peak;
+		// Sizes of the first allocations after record_base
+		size_t record_base;
+		size_t sizes[8];
+	};
+
+	namespace details
+	{
+		AllocationCounters& allocation_counters();
+
+		struct AllocationMark
+		{
+			size_t allocations;
+			size_t bytes;
+			size_t record_base;
+		};
+		AllocationMark mark_allocations();
+		void check_allocations(const Assertion& info, const AllocationMark& mark);
+	}
+
+	template <class Proc>
+	void check_no_alloc(const Assertion& info, const Proc& test)
+	{
+		info.increaseCount();
+		const auto mark = details::mark_allocations();
+		test();
+		details::check_allocations(info, mark);
+	}
+
+	// Fails if anything is allocated on this thread during the lifetime of the scope
+	class NoAllocScope
+	{
+		Assertion _info;
+		details::AllocationMark _mark;
+	public:
+		NoAllocScope(const Assertion& info);
+		~NoAllocScope();
+	};
+
 	namespace details
 	{
 		template <class T>
@@ -356,38 +431,282 @@ namespace tester
 		template <class T>
 		anything_end<T, is_iterable<T>::value> end(T& x) { return { x }; }
 
+		template <class T, class = void>
+		struct is_contiguous_arithmetic : std::false_type { };
+		template <class T>
+		struct is_contiguous_arithmetic<T, std::void_t<decltype(std::data(std::declval<T&>())), decltype(std::size(std::declval<T&>()))>>
+			: std::is_arithmetic<std::remove_cv_t<std::remove_pointer_t<decltype(std::data(std::declval<T&>()))>>> { };
+
+		// Element access for the block comparison, a scalar side repeats its value
+		template <class T, bool = is_contiguous_arithmetic<T>::value>
+		struct elements
+		{
+			decltype(std::data(std::declval<T&>())) data;
+			size_t size;
+
+			elements(T& c) : data(std::data(c)), size(std::size(c)) { }
+
+			const auto& operator[](size_t i) const { return data[i]; }
+		};
+		template <class T>
+		struct elements<T, false>
+		{
+			const T& value;
+			static constexpr size_t size = size_t(-1);
+
+			elements(T& v) : value(v) { }
+
+			const T& operator[](size_t) const { return value; }
+		};
+
+		// Elements compared at once by the block comparison of check_each
+		static constexpr size_t block_size = 256;
+
+		// Mismatches of a block counted without visiting them one by one, for those past the reported ones
+		struct BlockTally
+		{
+			size_t count = 0;
+			// Runs of mismatches starting in the block
+			size_t runs = 0;
+			// Whether the block comparison could not decide some element, the block is then walked element by element
+			bool undecided = false;
+			// Whether some approximate mismatch has a larger error than the largest so far
+			bool larger_error = false;
+		};
+		// Counts the mismatch flags mismatch[1..size], mismatch[0] being the element before the block
+		inline BlockTally count_runs(const unsigned char* mismatch, size_t size)
+		{
+			unsigned count = 0;
+			unsigned runs = 0;
+			for (size_t i = 1; i <= size; ++i)
+			{
+				count += mismatch[i];
+				runs += mismatch[i] & (mismatch[i - 1] ^ 1u);
+			}
+			BlockTally tally;
+			tally.count = count;
+			tally.runs = runs;
+			return tally;
+		}
+
+		// Branch free comparison of a block, which compilers vectorize at -O3 when the target has
+		// the needed compares and selects, e.g. -march=x86-64-v3
+		template <template <Op> class Comparer, Op OP>
+		struct BlockComparer
+		{
+			template <class A, class B>
+			static bool all(const A& a, const B& b, size_t begin, size_t end)
+			{
+				unsigned mismatch = 0;
+				for (size_t i = begin; i < end; ++i)
+					mismatch |= unsigned(!Comparer<OP>::apply(a[i], b[i]));
+				return mismatch == 0;
+			}
+			template <class A, class B>
+			static BlockTally tally(const A& a, const B& b, size_t begin, size_t end, bool previous, double, double)
+			{
+				unsigned char mismatch[block_size + 1];
+				mismatch[0] = previous;
+				for (size_t i = begin; i < end; ++i)
+					mismatch[i - begin + 1] = !Comparer<OP>::apply(a[i], b[i]);
+				return count_runs(mismatch, end - begin);
+			}
+		};
+		template <Op OP>
+		struct BlockComparer<Approximator, OP>
+		{
+			// Same test as Approximator<Op::EQ>, squared to avoid the sqrt and written with bitwise operators
+			// instead of ?: and &&, which would keep the loop from vectorizing
+			// Elements it cannot decide for sure are rechecked one by one: those within rounding of the
+			// threshold, and those whose squares overflow or are nan
+			struct Verdict
+			{
+				bool equal;
+				bool different;
+			};
+			static Verdict judge(double x, double y, double p, double p2)
+			{
+				constexpr double margin = 1e-6;
+				constexpr double largest = std::numeric_limits<double>::max();
+				const double mx = std::abs(x);
+				const double my = std::abs(y);
+				const double mm2 = mx * my;
+				const double d2 = (x - y) * (x - y);
+				const double limit = p2 * mm2;
+				const bool zero = mm2 == 0;
+				const bool small = (mx < p) & (my < p);
+				const bool finite = (mm2 <= largest) & (d2 <= largest);
+				const bool equal = (zero & small) | (!zero & (d2 < limit * (1 - margin)));
+				const bool different = (zero & !small) | (!zero & finite & (d2 > limit * (1 + margin)));
+				return { equal, different };
+			}
+			template <class A, class B>
+			static bool all(const A& a, const B& b, size_t begin, size_t end)
+			{
+				const double p = presicion();
+				const double p2 = p * p;
+				unsigned mismatch = 0;
+				for (size_t i = begin; i < end; ++i)
+				{
+					const auto verdict = judge(double(a[i]), double(b[i]), p, p2);
+					mismatch |= unsigned(OP == Op::EQ ? !verdict.equal : !verdict.different);
+				}
+				return mismatch == 0;
+			}
+			// The relative error is compared multiplied out, without the division of Mismatches::error
+			template <class A, class B>
+			static BlockTally tally(const A& a, const B& b, size_t begin, size_t end, bool previous, double max_abs, double max_rel)
+			{
+				const double p = presicion();
+				const double p2 = p * p;
+				unsigned char mismatch[block_size + 1];
+				mismatch[0] = previous;
+				unsigned undecided = 0;
+				unsigned larger = 0;
+				for (size_t i = begin; i < end; ++i)
+				{
+					const double x = double(a[i]);
+					const double y = double(b[i]);
+					const auto verdict = judge(x, y, p, p2);
+					const bool differs = OP == Op::EQ ? verdict.different : verdict.equal;
+					const double error = std::abs(x - y);
+					mismatch[i - begin + 1] = differs;
+					undecided |= unsigned(!verdict.equal & !verdict.different);
+					larger |= unsigned(differs & ((error > max_abs) | (error > max_rel * std::max(std::abs(x), std::abs(y)))));
+				}
+				auto tally = count_runs(mismatch, end - begin);
+				tally.undecided = undecided != 0;
+				tally.larger_error = larger != 0;
+				return tally;
+			}
+		};
+
+		// Elements printed one by one per failed check_each, see RunOptions::mismatch_limit
+		size_t mismatch_limit();
+
+		// Summary of all mismatching elements of a check_each
+		struct Mismatches
+		{
+			size_t count = 0;
+			size_t first = 0;
+			size_t last = 0;
+			// Contiguous runs of mismatches, the first mismatch_limit() of them kept as [begin, end)
+			size_t range_count = 0;
+			std::vector<std::pair<size_t, size_t>> ranges;
+			// Largest differences of approximate comparisons
+			bool has_error = false;
+			double max_abs = 0;
+			size_t max_abs_index = 0;
+			double max_rel = 0;
+			size_t max_rel_index = 0;
+
+			void add(size_t i, size_t limit);
+			void error(size_t i, double a, double b);
+		};
+		std::ostream& operator<<(std::ostream& out, const Mismatches& mismatches);
+
 		template <template <Op> class Comparer, class First, class Last, Op OP>
 		void check_each(const Assertion& info, const result::Type<Last, result::TypeOp<First, OP>>& result)
 		{
-			using result_type = std::decay_t<decltype(result)>;
-			Assertion::increaseCount();
+			info.increaseCount();
 			Subreport subreport;
 
 			bool no_report = true;
 			bool print_report = false;
-			auto report_once = [&] { if (no_report) { print_report = report_failure(); no_report = false; } };
-			static constexpr bool a_iterable = details::is_iterable<decltype(result.rest.last)>::value;
-			static constexpr bool b_iterable = details::is_iterable<decltype(result.last)>::value;
-			static_assert(a_iterable || b_iterable, "neither side is iterable");
-			auto ita  = ::tester::details::begin(result.rest.last); 
-			auto enda = ::tester::details::end  (result.rest.last);
-			auto itb  = ::tester::details::begin(result.last); 
-			auto endb = ::tester::details::end  (result.last);
-
-			for (size_t i = 0; ita != enda && itb != endb; ++ita, ++itb, ++i)
+			const size_t limit = mismatch_limit();
+			Mismatches mismatches;
+			auto report_once = [&] { if (no_report) { print_report = report_failure(info); no_report = false; } };
+			// Returns false once nothing more will be reported, only the first failure of a site is
+			auto compare = [&](size_t i, const auto& a, const auto& b)
 			{
-				if (!Comparer<OP>::apply(*ita, *itb))
+				if (!Comparer<OP>::apply(a, b))
 				{
 					report_once();
-					if (print_report)
+					if (!print_report)
+						return false;
+					if (mismatches.count < limit)
 					{
 						subreport <<
 							"at index " << i << ":\n"
-							"    " << print(*ita) << ' ' << OP << ' ' << print(*itb) << '\n';
+							"    " << print(a) << ' ' << OP << ' ' << print(b) << '\n';
 					}
+					mismatches.add(i, limit);
+					using TA = std::remove_cv_t<std::remove_reference_t<decltype(a)>>;
+					using TB = std::remove_cv_t<std::remove_reference_t<decltype(b)>>;
+					if constexpr (std::is_same_v<Comparer<OP>, Approximator<OP>> && std::is_arithmetic_v<TA> && std::is_arithmetic_v<TB>)
+						mismatches.error(i, double(a), double(b));
 				}
+				return true;
+			};
+			using A = std::remove_reference_t<decltype((result.rest.last))>;
+			using B = std::remove_reference_t<decltype((result.last))>;
+			static constexpr bool a_iterable = details::is_iterable<A>::value;
+			static constexpr bool b_iterable = details::is_iterable<B>::value;
+			static_assert(a_iterable || b_iterable, "neither side is iterable");
+			static constexpr bool a_contiguous = is_contiguous_arithmetic<A>::value;
+			static constexpr bool b_contiguous = is_contiguous_arithmetic<B>::value;
+
+			bool different_size = false;
+			if constexpr (
+				(a_contiguous || std::is_arithmetic_v<std::remove_cv_t<A>>) &&
+				(b_contiguous || std::is_arithmetic_v<std::remove_cv_t<B>>))
+			{
+				// Contiguous numeric data: compare whole blocks and only walk the ones that mismatch
+				const elements<A> a(result.rest.last);
+				const elements<B> b(result.last);
+				const size_t size = std::min(a.size, b.size);
+				using Block = BlockComparer<Comparer, OP>;
+				auto walk = [&](size_t begin, size_t end)
+				{
+					for (size_t i = begin; i < end; ++i)
+						if (!compare(i, a[i], b[i]))
+							return false;
+					return true;
+				};
+				for (size_t begin = 0; begin < size; begin += block_size)
+				{
+					const size_t end = std::min(size, begin + block_size);
+					// Past the runs kept for the report, mismatches are only counted, a block at a time
+					if (!print_report || mismatches.range_count <= limit)
+					{
+						if (!Block::all(a, b, begin, end) && !walk(begin, end))
+							return;
+						continue;
+					}
+					const auto tally = Block::tally(a, b, begin, end, mismatches.last + 1 == begin, mismatches.max_abs, mismatches.max_rel);
+					if (tally.undecided)
+					{
+						walk(begin, end);
+						continue;
+					}
+					if (tally.count == 0)
+						continue;
+					size_t last = end - 1;
+					while (Comparer<OP>::apply(a[last], b[last]))
+						--last;
+					mismatches.count += tally.count;
+					mismatches.range_count += tally.runs;
+					mismatches.last = last;
+					if constexpr (std::is_same_v<Comparer<OP>, Approximator<OP>>)
+						if (tally.larger_error)
+							for (size_t i = begin; i < end; ++i)
+								if (!Comparer<OP>::apply(a[i], b[i]))
+									mismatches.error(i, double(a[i]), double(b[i]));
+				}
+				different_size = a_contiguous && b_contiguous && a.size != b.size;
+			}
+			else
+			{
+				auto ita  = ::tester::details::begin(result.rest.last); 
+				auto enda = ::tester::details::end  (result.rest.last);
+				auto itb  = ::tester::details::begin(result.last); 
+				auto endb = ::tester::details::end  (result.last);
+
+				for (size_t i = 0; ita != enda && itb != endb; ++ita, ++itb, ++i)
+					if (!compare(i, *ita, *itb))
+						return;
+				different_size = (a_iterable && b_iterable && (ita != enda || itb != endb));
 			}
-			const bool different_size = (a_iterable && b_iterable && (ita != enda || itb != endb));
 			if (different_size)
 				report_once();
 			if (print_report)
@@ -404,6 +723,8 @@ namespace tester
 					subreport <<
 						info << "failed: element-by-element mismatch:\n" <<
 						pack_subreport;
+					if (mismatches.count > limit)
+						subreport << mismatches;
 				}
 			}
 		}
@@ -415,17 +736,123 @@ namespace tester
 		details::check_each<Applier>(info, result);
 	}
 	template <class First, class Last, Op OP>
-	void check_each_approx(const Assertion& info, const result::Type<Last, result::TypeOp<First, OP>>& test)
+	void check_each_approx(const Assertion& info, const result::Type<Last, result::TypeOp<First, OP>>& result)
 	{
 		details::check_each<Approximator>(info, result);
 	}
 
+	namespace details
+	{
+		struct Inbox;
+	}
+
+	// The case running on the calling thread, so that assertions on threads it starts count toward it
+	using Context = std::shared_ptr<details::Inbox>;
+	Context context();
+
+	// Assertions on the calling thread count toward the given case while the scope lives
+	// Threads outside one take the running case on their first assertion, if it is the only one in the process,
+	// otherwise their assertions count toward the run and are reported once it ends
+	// Either way their counts and failures are merged into the subcase running the case once the scope ends or
+	// the thread exits, so threads have to be joined before the subcase that started them returns
+	class Adopt
+	{
+	public:
+		explicit Adopt(Context context);
+		~Adopt();
+		Adopt(const Adopt&) = delete;
+		Adopt& operator=(const Adopt&) = delete;
+	};
+
+	namespace details
+	{
+		// The part of Fixture that does not depend on the type
+		class FixtureBase
+		{
+			const char* _name;
+			std::mutex _mutex;
+			std::atomic<bool> _ready = false;
+			// Process that built it, so that a fork does not tear down the fixture of its parent
+			int _owner = 0;
+			// Selected cases tagged with the name that are not done, and cases using it without the tag
+			size_t _users = 0;
+		protected:
+			explicit FixtureBase(const char* name);
+			~FixtureBase();
+
+			// Builds it on first use and counts the running case as a user until the case is done
+			void acquire();
+			virtual void setUp() = 0;
+			virtual void tearDown() = 0;
+		public:
+			FixtureBase(const FixtureBase&) = delete;
+			FixtureBase& operator=(const FixtureBase&) = delete;
+
+			const char* name() const { return _name; }
+
+			// For the runner
+			void expect(size_t users);
+			void release();
+			void reset();
+		};
+	}
+
+	// A resource shared between cases, like a loaded model or a populated database, built by the first case
+	// using it and torn down when the last case tagged with its name is done
+	// Cases without the tag hold it from their first use until they are done, threads using it while it is
+	// built wait for it, and its setup time is reported on its own instead of counting toward the case
+	//     static tester::Fixture<Database> database("database", [] { return Database::populate(); });
+	//     TEST_CASE("lookup", "[database]") { CHECK(database->find("key")); };
+	template <class T>
+	class Fixture : public details::FixtureBase
+	{
+		std::function<std::unique_ptr<T>()> _make;
+		std::unique_ptr<T> _value;
+
+		void setUp() override { _value = _make(); }
+		void tearDown() override { _value.reset(); }
+	public:
+		explicit Fixture(const char* name) : FixtureBase(name), _make([] { return std::make_unique<T>(); }) { }
+		template <class Setup>
+		Fixture(const char* name, Setup setup) 
+			: FixtureBase(name), _make([setup = std::move(setup)] { return std::make_unique<T>(setup()); }) { }
+
+		T& get() { acquire(); return *_value; }
+		T& operator*() { return get(); }
+		T* operator->() { return &get(); }
+	};
+
+	// Contiguous elements seen through a pointer and a size, like std::span, which the header avoids to stay C++17
+	template <class T>
+	class Span
+	{
+		T* _data = nullptr;
+		size_t _size = 0;
+	public:
+		constexpr Span() = default;
+		constexpr Span(T* data, size_t size) : _data(data), _size(size) { }
+
+		constexpr T* data() const { return _data; }
+		constexpr size_t size() const { return _size; }
+		constexpr bool empty() const { return _size == 0; }
+		constexpr T* begin() const { return _data; }
+		constexpr T* end() const { return _data + _size; }
+		constexpr T& operator[](size_t i) const { return _data[i]; }
+	};
+
+	// The table in link order, empty where the linker does not build it and the entries are registered instead
+	Span<const CaseEntry> caseTable();
+
 	class Case
 	{
 		const char* _name;
+		const char* _tags;
+		double _timeout;
 	public:
 
-		Case(const char* name) : _name(name){ }
+		// Tags are written as "[fast][io]"
+		// A timeout in seconds overrides RunOptions::case_timeout for this case
+		Case(const char* name, const char* tags = "", double timeout = 0) : _name(name), _tags(tags), _timeout(timeout) { }
 
 		Case operator<<(Procedure proc) && ;
 	};
@@ -437,18 +864,279 @@ namespace tester
 		Subcase(std::string_view name);
 		~Subcase();
 
-		void operator<<(const Procedure& procedure) const;
+		template <class Proc>
+		void operator<<(Proc&& procedure) const { if (_shall_enter) enter(procedure); }
+	private:
+		static void enter(ProcedureRef procedure);
 	};
 
 	class Repeat
 	{
 		size_t _count;
+		size_t _threads = 1;
 	public:
 		Repeat(size_t count) : _count(count) { }
 
-		void operator<<(const Procedure& procedure) const;
+		// Splits the iterations over threads, 0 means one per hardware thread
+		// Each thread has its own subcase state, so the body must not contain subcases, which throw std::logic_error,
+		// and anything it shares must be safe to use from several threads
+		Repeat& parallel(size_t threads = 0) { _threads = threads; return *this; }
+
+		template <class Proc>
+		void operator<<(Proc&& procedure) const { run(procedure); }
+	private:
+		void run(ProcedureRef procedure) const;
+	};
+
+	// Keeps the compiler from optimizing away the computation of value
+	template <class T>
+	inline void DoNotOptimize(const T& value)
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		asm volatile("" : : "r,m"(value) : "memory");
+#else
+		static volatile const void* sink;
+		sink = &value;
+		_ReadWriteBarrier();
+#endif
+	}
+	// Forces pending writes to memory to be treated as observable
+	inline void ClobberMemory()
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		asm volatile("" : : : "memory");
+#else
+		_ReadWriteBarrier();
+#endif
+	}
+
+	struct BenchmarkStats
+	{
+		std::string name;
+		size_t iterations = 0;
+		size_t samples = 0;
+		// Seconds per iteration
+		double min = 0;
+		double median = 0;
+		double mean = 0;
+		double mad = 0;
+		double stddev = 0;
+		// Of single iterations, only measured by Latency, where median is the 50th percentile
+		double p90 = 0;
+		double p99 = 0;
+		double p999 = 0;
+		double max = 0;
+	};
+
+	std::ostream& operator<<(std::ostream& out, const BenchmarkStats& stats);
+
+	// Times a procedure over a number of samples and adds the statistics to the report
+	// The iteration count per sample is calibrated so each sample takes at least sample_time seconds
+	// Place it inside a Subcase to sweep over parameters
+	class Benchmark
+	{
+		std::string_view _name;
+		size_t _samples;
+		double _sample_time;
+
+		void run(const std::function<void(size_t)>& batch) const;
+	public:
+		Benchmark(std::string_view name, size_t samples = 30, double sample_time = 1e-3) 
+			: _name(name), _samples(samples), _sample_time(sample_time) { }
+
+		template <class Proc>
+		void operator<<(const Proc& procedure) const
+		{
+			run([&](size_t iterations) { for (size_t i = 0; i < iterations; ++i) procedure(); });
+		}
+	};
+
+	namespace details
+	{
+		void check_perf(const Assertion& info, const std::function<void(size_t)>& batch, size_t samples, double sample_time);
+	}
+
+	// Times a procedure like Benchmark and fails if it is slower than the stored baseline, see RunOptions::perf_baseline
+	template <class Proc>
+	void check_perf(const Assertion& info, const Proc& procedure, size_t samples = 30, double sample_time = 1e-3)
+	{
+		info.increaseCount();
+		details::check_perf(info, [&](size_t iterations) { for (size_t i = 0; i < iterations; ++i) procedure(); }, samples, sample_time);
+	}
+
+	// Counts of nanosecond values in buckets about 1.6% wide, over the whole range in fixed memory
+	// The layout is that of HdrHistogram with 6 significant bits
+	class LatencyHistogram
+	{
+	public:
+		static constexpr unsigned sub_bits = 6;
+		static constexpr size_t sub_count = size_t(1) << sub_bits;
+		static constexpr size_t bucket_count = (64 - sub_bits + 1) * sub_count;
+
+		// std::bit_width, which needs C++20
+		static unsigned bit_width(uint64_t x)
+		{
+#if defined(__GNUC__)
+			return x == 0 ? 0 : 64 - unsigned(__builtin_clzll(x));
+#else
+			unsigned width = 0;
+			for (; x != 0; x >>= 1)
+				width += 1;
+			return width;
+#endif
+		}
+
+		static size_t bucket(uint64_t nanoseconds)
+		{
+			if (nanoseconds < sub_count)
+				return size_t(nanoseconds);
+			const auto shift = bit_width(nanoseconds) - sub_bits - 1;
+			return (shift + 1) * sub_count + size_t(nanoseconds >> shift) - sub_count;
+		}
+		// The largest value counted in the bucket
+		static uint64_t highest(size_t bucket)
+		{
+			if (bucket < 2 * sub_count)
+				return bucket;
+			const auto shift = unsigned(bucket / sub_count - 1);
+			return ((uint64_t(bucket - shift * sub_count) + 1) << shift) - 1;
+		}
+
+		void record(uint64_t nanoseconds)
+		{
+			if (_counts.empty())
+				_counts.resize(bucket_count);
+			_counts[bucket(nanoseconds)] += 1;
+			_count += 1;
+			_min = std::min(_min, nanoseconds);
+			_max = std::max(_max, nanoseconds);
+			_sum += double(nanoseconds);
+			_sum_squares += double(nanoseconds) * double(nanoseconds);
+		}
+
+		uint64_t count() const { return _count; }
+		// In seconds, like BenchmarkStats
+		double min() const { return _count ? double(_min) * 1e-9 : 0; }
+		double max() const { return double(_max) * 1e-9; }
+		double mean() const { return _count ? _sum / double(_count) * 1e-9 : 0; }
+		double stddev() const;
+		// Median absolute deviation from the median, to the precision of the buckets
+		double mad() const;
+		// The value that percent of the values are at or below, to the precision of the buckets
+		double percentile(double percent) const;
+
+	private:
+		std::vector<uint64_t> _counts;
+		uint64_t _count = 0;
+		uint64_t _min = uint64_t(-1);
+		uint64_t _max = 0;
+		double _sum = 0;
+		double _sum_squares = 0;
+	};
+
+	// Times every iteration of a Repeat into a histogram, for checks like CHECK_PERCENTILE_BELOW
+	// The histogram is added to the report as a benchmark with percentiles
+	class Latency
+	{
+		std::string_view _name;
+		size_t _count;
+		LatencyHistogram _histogram;
+
+		void run(ProcedureRef procedure);
+	public:
+		Latency(std::string_view name, size_t count) : _name(name), _count(count) { }
+
+		template <class Proc>
+		Latency& operator<<(Proc&& procedure) { run(procedure); return *this; }
+
+		const LatencyHistogram& histogram() const { return _histogram; }
+	};
+
+	// Fails if the percentile of the latency is not below limit seconds
+	// The Repeat of a Latency only runs in one pass over the case, in the others the check is skipped
+	void check_percentile_below(const Assertion& info, const Latency& latency, double percent, double limit);
+	template <class Rep, class Period>
+	void check_percentile_below(const Assertion& info, const Latency& latency, double percent, std::chrono::duration<Rep, Period> limit)
+	{
+		check_percentile_below(info, latency, percent, std::chrono::duration<double>(limit).count());
+	}
+
+	// A case whose whole body is a benchmark, the body must not contain subcases
+	class BenchmarkCase
+	{
+		const char* _name;
+		const char* _tags;
+		double _timeout;
+	public:
+		BenchmarkCase(const char* name, const char* tags = "", double timeout = 0) : _name(name), _tags(tags), _timeout(timeout) { }
+
+		BenchmarkCase operator<<(Procedure proc) && ;
+	};
+
+	using Bytes = Span<const unsigned char>;
+
+	// A case over arbitrary input, runTests passes it every file in RunOptions::fuzz_corpus/<name>
+	// Fuzzers run it through fuzzOne, see src/tester_fuzz.cpp
+	class FuzzCase
+	{
+		const char* _name;
+		const char* _tags;
+		double _timeout;
+	public:
+		FuzzCase(const char* name, const char* tags = "", double timeout = 0) : _name(name), _tags(tags), _timeout(timeout) { }
+
+		FuzzCase operator<<(void (*body)(Bytes)) && ;
+	};
+
+	// Runs one input through a fuzz case without the per subcase setup of runTests
+	// A failed assertion prints its report and aborts, which fuzzers take for a crash
+	// The name can be null when a single fuzz case is registered
+	int fuzzOne(const char* name, const unsigned char* data, size_t size);
+
+
+	// Time spent running subcases, in seconds, and hardware counters where perf events are permitted
+	struct Timing
+	{
+		double wall = 0;
+		double cpu = 0;
+		// Whether the counters below were measured
+		bool counters = false;
+		uint64_t cycles = 0;
+		uint64_t instructions = 0;
+		uint64_t cache_misses = 0;
+		uint64_t branch_misses = 0;
+
+		Timing& operator+=(const Timing& other)
+		{
+			wall += other.wall;
+			cpu += other.cpu;
+			counters = counters || other.counters;
+			cycles += other.cycles;
+			instructions += other.instructions;
+			cache_misses += other.cache_misses;
+			branch_misses += other.branch_misses;
+			return *this;
+		}
 	};
 
+	std::ostream& operator<<(std::ostream& out, const Timing& timing);
+
+	// Allocations while running subcases, see AllocationCounters
+	struct AllocationStats
+	{
+		size_t allocations = 0;
+		size_t bytes = 0;
+		// Highest number of live bytes above the level at the start of a subcase run
+		size_t peak = 0;
+
+		AllocationStats& operator+=(const AllocationStats& other)
+		{
+			allocations += other.allocations;
+			bytes += other.bytes;
+			peak = std::max(peak, other.peak);
+			return *this;
+		}
+	};
 
 	struct TestResults
 	{
@@ -456,7 +1144,130 @@ namespace tester
 		size_t assert_count = 0;
 		size_t fail_count = 0;
 		size_t exception_count = 0;
+		size_t benchmark_count = 0;
+		Timing timing;
+		AllocationStats allocations;
+
+		TestResults& operator+=(const TestResults& other)
+		{
+			subcase_count += other.subcase_count;
+			assert_count += other.assert_count;
+			fail_count += other.fail_count;
+			exception_count += other.exception_count;
+			benchmark_count += other.benchmark_count;
+			timing += other.timing;
+			allocations += other.allocations;
+			return *this;
+		}
+	};
+
+	struct SubcaseInfo
+	{
+		std::string id;
+		size_t assert_count = 0;
+		size_t fail_count = 0;
+		size_t exception_count = 0;
+		size_t benchmark_count = 0;
+		Timing timing;
+		AllocationStats allocations;
+	};
+
+	// A failing assertion site or an uncaught exception, aggregated over one subcase run
+	struct Failure
+	{
+		std::string path;
+		// Empty for exceptions
+		std::string file;
+		unsigned line = 0;
+		std::string expr;
+		// The text as it appears in the report
+		std::string message;
+		size_t count = 0;
+	};
+
+	// Receives the events of a run as they happen
+	// When cases run on several threads or processes, the events of each case are delivered together, in registration order
+	class Reporter
+	{
+	public:
+		virtual ~Reporter() = default;
+
+		virtual void caseStarted(std::string_view /*name*/) { }
+		virtual void assertionFailed(const Failure& /*failure*/) { }
+		virtual void exceptionThrown(const Failure& /*failure*/) { }
+		virtual void benchmarkDone(const BenchmarkStats& /*stats*/) { }
+		virtual void fixtureSetUp(std::string_view /*name*/, const Timing& /*timing*/) { }
+		virtual void subcaseDone(const SubcaseInfo& /*info*/) { }
+		virtual void caseDone(std::string_view /*name*/, const TestResults& /*results*/) { }
+		virtual void runDone(const TestResults& /*results*/, size_t /*case_count*/, double /*seconds*/) { }
+		// Called before the process exits on a timeout
+		virtual void flush() { }
+	};
+
+	// Exit status when a run is stopped by RunOptions::case_timeout or run_timeout
+	static constexpr int timeout_status = 124;
+
+	struct RunOptions
+	{
+		// Number of worker threads, 0 means one per hardware thread
+		size_t threads = 1;
+		// Number of forked worker processes, 0 runs everything in this process
+		// A case that crashes its worker is reported as an uncaught exception
+		size_t processes = 0;
+		// Only run every shard_count'th case, starting at shard_index
+		size_t shard_index = 0;
+		size_t shard_count = 1;
+		// Case name patterns, glob with * and ? or a regex after "re:"
+		// A pattern starting with ~ excludes, otherwise a case must match one of the patterns
+		std::vector<std::string> case_filters;
+		// Tag patterns like case_filters, matched against the tags given at registration, without brackets
+		std::vector<std::string> tag_filters;
+		// Globs for each level of a subcase path, like "case/subcase/*"
+		// Subcases off every path are skipped before they run, a path also selects everything below it
+		std::vector<std::string> subcase_filters;
+		// Fork at each Subcase instead of re-running the case from the top for every leaf,
+		// so setup before a Subcase runs once. A crashing subcase is reported as an uncaught exception
+		// POSIX only, and best combined with processes rather than threads
+		bool fork_subcases = false;
+		// Number of slowest cases and subcases listed at the end of the text report
+		size_t slowest = 10;
+		// Time budgets in seconds, 0 means none. A case over budget is reported with its subcase path and
+		// the last assertion reached. With processes its worker is stopped and the run goes on, otherwise
+		// the partial results are reported, the default report is written to stdout and the process exits
+		// with timeout_status. Over the run budget, the process always exits that way
+		double case_timeout = 0;
+		double run_timeout = 0;
+		// File keeping the duration and outcome of each case between runs, empty means none
+		// When set, cases that failed last time run first, then new cases, then the rest longest first
+		std::string timing_database;
+		// File of timing samples that CHECK_PERF compares with, empty means CHECK_PERF only measures
+		// Measurements without a baseline are added to it, and all of them with perf_record
+		std::string perf_baseline;
+		bool perf_record = false;
+		// A measurement fails when a one-sided Mann-Whitney U test finds it slower than its baseline at
+		// significance perf_alpha, and its median is more than perf_tolerance slower, relatively
+		double perf_alpha = 0.01;
+		double perf_tolerance = 0.05;
+		// Mismatching elements printed one by one by check_each, the rest are summarized
+		size_t mismatch_limit = 10;
+		// Write the selected cases to tester::report instead of running them
+		bool list = false;
+		// File to record every assertion executed into, decoded by tools/tester_trace.cpp
+		std::string trace;
+		// Directory with a subdirectory of inputs per fuzz case, empty runs each fuzz case once with no input
+		std::string fuzz_corpus;
+		// Trials per Property, and the seed its arguments are generated from, 0 picks one at random
+		size_t property_trials = 100;
+		uint64_t seed = 0;
+		// Receives the results, null means text into tester::report
+		std::shared_ptr<Reporter> reporter;
 	};
 
-	TestResults runTests();
+	TestResults runTests(const RunOptions& options = {});
+	// Recognizes --threads N, --processes N, --shard i/m, --case pattern, --tag pattern, --subcase path,
+	// --fork-subcases, --slowest N, --timeout seconds, --run-timeout seconds, --timing-db path, --perf-baseline path,
+	// --perf-record, --perf-alpha p, --perf-tolerance fraction, --mismatch-limit N, --corpus dir, --trace path, --list, --trials N, --seed N, --reporter text|junit|jsonl
+	// and --output path
+	// Other arguments are ignored
+	RunOptions parseArguments(int argc, const char* const argv[]);
 };
@@ -0,0 +1,45 @@
+#pragma once
+
+// The table of cases shared by tester.h and tester_slim.h, kept free of other includes
+
+namespace tester
+{
+	// A case defined with TESTER_TEST_CASE or TESTER_BENCHMARK, which the linker gathers into a constant table,
+	// so that defining, enumerating and listing cases takes no initializer or allocation before main
+	struct CaseEntry
+	{
+		const char* name;
+		const char* tags;
+		double timeout;
+		const char* file;
+		unsigned line;
+		bool benchmark;
+		void (*proc)();
+
+		static constexpr CaseEntry make(bool benchmark, void (*proc)(), const char* file, unsigned line,
+			const char* name, const char* tags = "", double timeout = 0)
+		{
+			return { name, tags, timeout, file, line, benchmark, proc };
+		}
+	};
+
+	// Registers an entry at startup, for platforms without the table
+	int registerCase(const CaseEntry& entry);
+}
+
+#define TESTER_PASTE_IMPL(a, b) a ## b
+#define TESTER_PASTE(a, b) TESTER_PASTE_IMPL(a, b)
+
+// Cases are entries of a table the linker gathers in ELF binaries, elsewhere they register at startup
+#if defined(__ELF__)
+#define TESTER_CASE_ENTRY(id, benchmark, ...) \
+	static void id(); \
+	[[gnu::used, gnu::section("tester_cases")]] alignas(::tester::CaseEntry) static constexpr ::tester::CaseEntry TESTER_PASTE(id, _entry) = \
+		::tester::CaseEntry::make(benchmark, id, __FILE__, __LINE__, __VA_ARGS__); \
+	static void id()
+#else
+#define TESTER_CASE_ENTRY(id, benchmark, ...) \
+	static void id(); \
+	static const int TESTER_PASTE(id, _entry) = ::tester::registerCase(::tester::CaseEntry::make(benchmark, id, __FILE__, __LINE__, __VA_ARGS__)); \
+	static void id()
+#endif
@@ -0,0 +1,502 @@
+#pragma once
+
+#include "tester.h"
+
+#include <tuple>
+#include <limits>
+#include <string>
+
+namespace tester
+{
+	// xoshiro256** seeded through splitmix64
+	class Random
+	{
+		uint64_t _s[4];
+
+		static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+	public:
+		explicit Random(uint64_t seed)
+		{
+			for (auto& s : _s)
+			{
+				seed += 0x9e3779b97f4a7c15ull;
+				uint64_t z = seed;
+				z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+				z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+				s = z ^ (z >> 31);
+			}
+		}
+		// An independent stream for each name
+		Random(uint64_t seed, std::string_view name) : Random(seed ^ std::hash<std::string_view>{}(name)) { }
+
+		uint64_t next()
+		{
+			const auto result = rotl(_s[1] * 5, 7) * 9;
+			const auto t = _s[1] << 17;
+			_s[2] ^= _s[0];
+			_s[3] ^= _s[1];
+			_s[1] ^= _s[2];
+			_s[0] ^= _s[3];
+			_s[2] ^= t;
+			_s[3] = rotl(_s[3], 45);
+			return result;
+		}
+		// Uniform in [0, n), or any value when n is 0
+		uint64_t below(uint64_t n)
+		{
+			if (n == 0)
+				return next();
+			const auto limit = (0 - n) % n;
+			for (;;)
+			{
+				const auto x = next();
+				if (x >= limit)
+					return x % n;
+			}
+		}
+		// Uniform in [0, 1)
+		double uniform() { return double(next() >> 11) * 0x1.0p-53; }
+		// True one time in n
+		bool oneIn(uint64_t n) { return below(n) == 0; }
+	};
+
+	// A generator has
+	//   value_type, the representation that is generated and shrunk
+	//   value_type generate(Random&) const
+	//   void shrink(const value_type&, std::vector<value_type>& candidates) const, appending simpler values, simplest first
+	//   get(const value_type&) const, the argument passed to the property
+
+	template <class T>
+	class Integers
+	{
+		T _min;
+		T _max;
+		T _origin;
+	public:
+		using value_type = T;
+
+		Integers(T min, T max) : _min(min), _max(max), _origin(std::clamp(T(0), min, max)) { }
+
+		T generate(Random& random) const
+		{
+			// Boundaries are tried more often than their share
+			if (random.oneIn(16))
+			{
+				const T special[] = { _min, _max, _origin };
+				return special[random.below(3)];
+			}
+			using U = std::make_unsigned_t<T>;
+			const auto span = U(U(_max) - U(_min)) + uint64_t(1);
+			return T(U(_min) + U(random.below(span)));
+		}
+		void shrink(const T& value, std::vector<T>& candidates) const
+		{
+			if (value == _origin)
+				return;
+			candidates.push_back(_origin);
+			// Steps towards the origin of half the distance, a quarter and so on
+			for (auto step = T((value - _origin) / 2); step != 0; step = T(step / 2))
+				candidates.push_back(T(value - step));
+		}
+		const T& get(const T& value) const { return value; }
+	};
+	template <class T = int>
+	Integers<T> integers(T min = std::numeric_limits<T>::min(), T max = std::numeric_limits<T>::max()) { return { min, max }; }
+
+	template <class T>
+	class Floats
+	{
+		T _min;
+		T _max;
+		T _origin;
+	public:
+		using value_type = T;
+
+		Floats(T min, T max) : _min(min), _max(max), _origin(std::clamp(T(0), min, max)) { }
+
+		T generate(Random& random) const
+		{
+			if (random.oneIn(16))
+			{
+				const T special[] = { _min, _max, _origin };
+				return special[random.below(3)];
+			}
+			return std::clamp(T(_min + (_max - _min) * random.uniform()), _min, _max);
+		}
+		void shrink(const T& value, std::vector<T>& candidates) const
+		{
+			if (value == _origin || !std::isfinite(value))
+				return;
+			candidates.push_back(_origin);
+			const auto whole = std::clamp(std::trunc(value), _min, _max);
+			if (whole != value)
+				candidates.push_back(whole);
+			const auto half = std::clamp(T(_origin + (value - _origin) / 2), _min, _max);
+			if (half != value && half != _origin)
+				candidates.push_back(half);
+		}
+		const T& get(const T& value) const { return value; }
+	};
+	template <class T = double>
+	Floats<T> floats(T min = T(-1e6), T max = T(1e6)) { return { min, max }; }
+
+	// Vectors of elements from another generator
+	template <class Gen>
+	class Vectors
+	{
+		Gen _element;
+		size_t _min_size;
+		size_t _max_size;
+	public:
+		using value_type = std::vector<typename Gen::value_type>;
+
+		Vectors(Gen element, size_t min_size, size_t max_size) : _element(std::move(element)), _min_size(min_size), _max_size(max_size) { }
+
+		value_type generate(Random& random) const
+		{
+			value_type result(_min_size + random.below(_max_size - _min_size + 1));
+			for (auto& e : result)
+				e = _element.generate(random);
+			return result;
+		}
+		void shrink(const value_type& value, std::vector<value_type>& candidates) const
+		{
+			// Drop halves, then single elements, then simplify elements one at a time
+			for (auto size = value.size() / 2; size > 0 && value.size() - size >= _min_size; size /= 2)
+			{
+				candidates.emplace_back(value.begin(), value.end() - size);
+				candidates.emplace_back(value.begin() + size, value.end());
+			}
+			if (value.size() > _min_size)
+				for (size_t i = 0; i < value.size(); ++i)
+				{
+					candidates.push_back(value);
+					candidates.back().erase(candidates.back().begin() + i);
+				}
+			std::vector<typename Gen::value_type> simpler;
+			for (size_t i = 0; i < value.size(); ++i)
+			{
+				simpler.clear();
+				_element.shrink(value[i], simpler);
+				for (auto& e : simpler)
+				{
+					candidates.push_back(value);
+					candidates.back()[i] = std::move(e);
+				}
+			}
+		}
+		decltype(auto) get(const value_type& value) const
+		{
+			if constexpr (std::is_same_v<std::decay_t<decltype(_element.get(value.front()))>, typename Gen::value_type>)
+				return value;
+			else
+			{
+				std::vector<std::decay_t<decltype(_element.get(value.front()))>> result;
+				result.reserve(value.size());
+				for (auto& e : value)
+					result.push_back(_element.get(e));
+				return result;
+			}
+		}
+	};
+	template <class Gen>
+	Vectors<Gen> vectors(Gen element, size_t max_size = 32, size_t min_size = 0) { return { std::move(element), min_size, max_size }; }
+
+	// Strings of characters from another generator, printable ASCII by default
+	template <class Gen = Integers<char>>
+	class Strings
+	{
+		Vectors<Gen> _chars;
+	public:
+		using value_type = std::string;
+
+		Strings(Gen chars, size_t min_size, size_t max_size) : _chars(std::move(chars), min_size, max_size) { }
+
+		std::string generate(Random& random) const
+		{
+			const auto chars = _chars.generate(random);
+			return { chars.begin(), chars.end() };
+		}
+		void shrink(const std::string& value, std::vector<std::string>& candidates) const
+		{
+			std::vector<typename Vectors<Gen>::value_type> simpler;
+			_chars.shrink({ value.begin(), value.end() }, simpler);
+			for (auto& s : simpler)
+				candidates.emplace_back(s.begin(), s.end());
+		}
+		const std::string& get(const std::string& value) const { return value; }
+	};
+	inline Strings<> strings(size_t max_size = 32, size_t min_size = 0) { return { integers<char>(' ', '~'), min_size, max_size }; }
+	template <class Gen>
+	Strings<Gen> strings(Gen chars, size_t max_size = 32, size_t min_size = 0) { return { std::move(chars), min_size, max_size }; }
+
+	// One of the given values, shrinking towards the first
+	template <class T>
+	class Elements
+	{
+		std::vector<T> _values;
+	public:
+		using value_type = size_t;
+
+		Elements(std::vector<T> values) : _values(std::move(values)) { }
+
+		size_t generate(Random& random) const { return size_t(random.below(_values.size())); }
+		void shrink(size_t index, std::vector<size_t>& candidates) const
+		{
+			for (size_t i = 0; i < index && i < 4; ++i)
+				candidates.push_back(i);
+		}
+		const T& get(size_t index) const { return _values[index]; }
+	};
+	template <class T>
+	Elements<T> elements(std::initializer_list<T> values) { return { std::vector<T>(values) }; }
+
+	// Applies a function to generated values, shrinking happens on the values before the function
+	template <class Gen, class F>
+	class Mapped
+	{
+		Gen _source;
+		F _f;
+	public:
+		using value_type = typename Gen::value_type;
+
+		Mapped(Gen source, F f) : _source(std::move(source)), _f(std::move(f)) { }
+
+		value_type generate(Random& random) const { return _source.generate(random); }
+		void shrink(const value_type& value, std::vector<value_type>& candidates) const { _source.shrink(value, candidates); }
+		auto get(const value_type& value) const { return _f(_source.get(value)); }
+	};
+	template <class Gen, class F>
+	Mapped<Gen, F> mapped(Gen source, F f) { return { std::move(source), std::move(f) }; }
+
+	// Builds a T from values of several generators, shrinking one component at a time
+	template <class T, class... Gens>
+	class Construct
+	{
+		std::tuple<Gens...> _gens;
+	public:
+		using value_type = std::tuple<typename Gens::value_type...>;
+
+		Construct(Gens... gens) : _gens(std::move(gens)...) { }
+
+		value_type generate(Random& random) const
+		{
+			// Braces keep the generation order left to right
+			return std::apply([&](const auto&... gen) { return value_type{ gen.generate(random)... }; }, _gens);
+		}
+		void shrink(const value_type& value, std::vector<value_type>& candidates) const
+		{
+			shrinkEach(value, candidates, std::index_sequence_for<Gens...>{});
+		}
+		T get(const value_type& value) const
+		{
+			return std::apply([&](const auto&... gen)
+			{
+				return std::apply([&](const auto&... v) { return T{ gen.get(v)... }; }, value);
+			}, _gens);
+		}
+	private:
+		template <size_t... I>
+		void shrinkEach(const value_type& value, std::vector<value_type>& candidates, std::index_sequence<I...>) const
+		{
+			(shrinkOne<I>(value, candidates), ...);
+		}
+		template <size_t I>
+		void shrinkOne(const value_type& value, std::vector<value_type>& candidates) const
+		{
+			std::vector<std::tuple_element_t<I, value_type>> simpler;
+			std::get<I>(_gens).shrink(std::get<I>(value), simpler);
+			for (auto& s : simpler)
+			{
+				candidates.push_back(value);
+				std::get<I>(candidates.back()) = std::move(s);
+			}
+		}
+	};
+	template <class T, class... Gens>
+	Construct<T, Gens...> construct(Gens... gens) { return { std::move(gens)... }; }
+
+	namespace details
+	{
+		// Failing assertions on this thread are counted instead of reported while a Silence is alive
+		class Silence
+		{
+			size_t _failures;
+		public:
+			Silence();
+			~Silence();
+
+			// Failures since construction
+			size_t failures() const;
+		};
+
+		// RunOptions::property_trials and the seed in use
+		size_t property_trials();
+		uint64_t property_seed();
+
+		// Counterexamples print containers element by element
+		template <class T>
+		void print_argument(std::ostream& out, const T& value)
+		{
+			if constexpr (!is_streamable<T>::value && is_iterable<const T&>::value)
+			{
+				out << '{';
+				const char* separator = "";
+				for (auto& e : value)
+				{
+					out << separator;
+					print_argument(out, e);
+					separator = ", ";
+				}
+				out << '}';
+			}
+			else
+				out << print(value);
+		}
+	}
+
+	// Checks a property over generated arguments, reporting the simplest failing arguments found by shrinking
+	// The arguments are generated from a seed derived from the run seed and the property name, so --seed replays a run
+	template <class... Gens>
+	class Property
+	{
+		Assertion _info;
+		std::tuple<Gens...> _gens;
+		size_t _trials;
+		static constexpr size_t batch_size = 64;
+		static constexpr size_t max_shrinks = 1000;
+
+		using Input = std::tuple<typename Gens::value_type...>;
+	public:
+		Property(const Assertion& info, Gens... gens) : _info(info), _gens(std::move(gens)...), _trials(details::property_trials()) { }
+
+		Property& trials(size_t count) { _trials = count; return *this; }
+
+		template <class Body>
+		void operator<<(const Body& body) const
+		{
+			Subcase(_info.expr) << [&] { run(body); };
+		}
+
+	private:
+		template <class Body>
+		bool call(const Body& body, const Input& input) const
+		{
+			return std::apply([&](const auto&... gen)
+			{
+				return std::apply([&](const auto&... value)
+				{
+					if constexpr (std::is_same_v<decltype(body(gen.get(value)...)), bool>)
+						return body(gen.get(value)...);
+					else
+						return body(gen.get(value)...), true;
+				}, input);
+			}, _gens);
+		}
+		template <class Body>
+		bool holds(const Body& body, const Input& input) const
+		{
+			details::Silence silence;
+			try
+			{
+				return call(body, input) && silence.failures() == 0;
+			}
+			catch (...)
+			{
+				return false;
+			}
+		}
+
+		template <class Body>
+		void run(const Body& body) const
+		{
+			_info.increaseCount();
+			const auto seed = details::property_seed();
+			Random random(seed, _info.expr);
+
+			// Inputs are generated a batch at a time, and checking stops at the first failure
+			std::vector<Input> batch;
+			batch.reserve(std::min(_trials, batch_size));
+			size_t trial = 0;
+			const Input* failed = nullptr;
+			while (trial < _trials && !failed)
+			{
+				batch.clear();
+				for (size_t i = std::min(batch_size, _trials - trial); i > 0; --i)
+					batch.push_back(std::apply([&](const auto&... gen) { return Input{ gen.generate(random)... }; }, _gens));
+				for (auto& input : batch)
+				{
+					++trial;
+					if (!holds(body, input))
+					{
+						failed = &input;
+						break;
+					}
+				}
+			}
+			if (!failed)
+				return;
+
+			auto [smallest, shrinks] = shrink(body, *failed);
+			if (report_failure(_info))
+			{
+				Subreport subreport;
+				subreport << _info << "falsified after " << trial << " trials and " << shrinks << " shrinks, replay with --seed " << seed << '\n';
+				std::apply([&](const auto&... gen)
+				{
+					std::apply([&](const auto&... value)
+					{
+						size_t index = 0;
+						((subreport << "    argument " << ++index << ": ", details::print_argument(subreport, gen.get(value)), subreport << '\n'), ...);
+					}, smallest);
+				}, _gens);
+			}
+			// Run once more unsilenced, so the failing checks inside are reported
+			call(body, smallest);
+		}
+
+		// Greedy: take the first simpler candidate that still fails, until none does
+		template <class Body>
+		std::pair<Input, size_t> shrink(const Body& body, Input input) const
+		{
+			size_t shrinks = 0;
+			size_t attempts = 0;
+			std::vector<Input> candidates;
+			for (bool progress = true; progress && attempts < max_shrinks; )
+			{
+				progress = false;
+				candidates.clear();
+				candidatesOf(input, candidates, std::index_sequence_for<Gens...>{});
+				for (auto& candidate : candidates)
+				{
+					if (++attempts > max_shrinks)
+						break;
+					if (!holds(body, candidate))
+					{
+						input = std::move(candidate);
+						++shrinks;
+						progress = true;
+						break;
+					}
+				}
+			}
+			return { std::move(input), shrinks };
+		}
+		template <size_t... I>
+		void candidatesOf(const Input& input, std::vector<Input>& candidates, std::index_sequence<I...>) const
+		{
+			(candidatesOf<I>(input, candidates), ...);
+		}
+		template <size_t I>
+		void candidatesOf(const Input& input, std::vector<Input>& candidates) const
+		{
+			std::vector<std::tuple_element_t<I, Input>> simpler;
+			std::get<I>(_gens).shrink(std::get<I>(input), simpler);
+			for (auto& s : simpler)
+			{
+				candidates.push_back(input);
+				std::get<I>(candidates.back()) = std::move(s);
+			}
+		}
+	};
+}
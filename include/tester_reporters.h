@@ -0,0 +1,91 @@
+#pragma once
+
+#include "tester.h"
+
+namespace tester
+{
+	// Base for reporters writing to a stream, which they may own
+	class StreamReporter : public Reporter
+	{
+		std::unique_ptr<std::ostream> _owned;
+	protected:
+		std::ostream& out;
+	public:
+		StreamReporter(std::ostream& out) : out(out) { }
+		StreamReporter(std::unique_ptr<std::ostream> out) : _owned(std::move(out)), out(*_owned) { }
+
+		void flush() override { out.flush(); }
+	};
+
+	// The human readable format of tester::report
+	class TextReporter : public StreamReporter
+	{
+		struct Timed
+		{
+			std::string name;
+			Timing timing;
+		};
+		std::vector<Timed> _slowest_cases;
+		std::vector<Timed> _slowest_subcases;
+
+		void keepSlowest(std::vector<Timed>& list, std::string_view name, const Timing& timing);
+		void printSlowest(std::string_view title, std::vector<Timed>& list);
+	public:
+		using StreamReporter::StreamReporter;
+
+		// Number of slowest cases and subcases listed at the end
+		size_t slowest = 10;
+
+		void caseStarted(std::string_view name) override;
+		void assertionFailed(const Failure& failure) override;
+		void exceptionThrown(const Failure& failure) override;
+		void benchmarkDone(const BenchmarkStats& stats) override;
+		void fixtureSetUp(std::string_view name, const Timing& timing) override;
+		void subcaseDone(const SubcaseInfo& info) override;
+		void caseDone(std::string_view name, const TestResults& results) override;
+		void runDone(const TestResults& results, size_t case_count, double seconds) override;
+	};
+
+	// JUnit XML, with one testcase element per case
+	// The testsuite element leads with the totals, so cases are spooled to a temporary file as they finish
+	// and copied after it when the run is done
+	class JUnitReporter : public StreamReporter
+	{
+		std::ostringstream _case;
+		std::FILE* _spool = nullptr;
+		size_t _tests = 0;
+		size_t _failures = 0;
+		size_t _errors = 0;
+
+		void writeCase(std::string_view name, double seconds);
+	public:
+		using StreamReporter::StreamReporter;
+		~JUnitReporter() override;
+
+		void caseStarted(std::string_view name) override;
+		void assertionFailed(const Failure& failure) override;
+		void exceptionThrown(const Failure& failure) override;
+		void benchmarkDone(const BenchmarkStats& stats) override;
+		void caseDone(std::string_view name, const TestResults& results) override;
+		void runDone(const TestResults& results, size_t case_count, double seconds) override;
+	};
+
+	// One JSON object per line and event
+	class JsonLinesReporter : public StreamReporter
+	{
+	public:
+		using StreamReporter::StreamReporter;
+
+		void caseStarted(std::string_view name) override;
+		void assertionFailed(const Failure& failure) override;
+		void exceptionThrown(const Failure& failure) override;
+		void benchmarkDone(const BenchmarkStats& stats) override;
+		void fixtureSetUp(std::string_view name, const Timing& timing) override;
+		void subcaseDone(const SubcaseInfo& info) override;
+		void caseDone(std::string_view name, const TestResults& results) override;
+		void runDone(const TestResults& results, size_t case_count, double seconds) override;
+	};
+
+	// Creates one of the reporters above by name: text, junit or jsonl
+	std::shared_ptr<Reporter> makeReporter(std::string_view kind, std::unique_ptr<std::ostream> out);
+}
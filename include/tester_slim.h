@@ -0,0 +1,204 @@
+#pragma once
+
+// A lighter alternative to tester.h for test files, with the same macros
+// Values are only converted for printing when an assertion fails, and that happens out of line,
+// so no iostream, sstream or functional headers are pulled in and little is instantiated per check
+// Limitations compared to tester.h:
+//   user types print as {type name}, since their operator<< is not seen
+//   a CHECK holds one comparison, not a chain like a < b < c
+//   CHECK_APPROX only takes arithmetic operands
+//   CHECK_EACH, allocation checks, properties and benchmarks need tester.h
+// Cases registered through either header run together
+
+#include "tester_case_entry.h"
+
+#include <cstddef>
+#include <string_view>
+#include <type_traits>
+#include <typeinfo>
+
+namespace tester::slim
+{
+	// Same order as tester::Op
+	enum class Op { EQ, NE, SL, LE, SG, GE };
+
+	struct Assertion
+	{
+		const char* file;
+		unsigned    line;
+		const char* expr;
+	};
+
+	// An operand in the form it is printed in
+	struct Value
+	{
+		enum class Kind { Bool, Char, Signed, Unsigned, Float, Pointer, String, Opaque };
+
+		Kind kind = Kind::Opaque;
+		long long i = 0;
+		unsigned long long u = 0;
+		double f = 0;
+		const void* p = nullptr;
+		// The characters of a string, or the type name of an opaque value
+		std::string_view s;
+	};
+
+	template <class T>
+	Value describe(const T& x)
+	{
+		Value v;
+		if constexpr (std::is_same_v<T, bool>)
+			v.kind = Value::Kind::Bool, v.i = x;
+		else if constexpr (std::is_same_v<T, char> || std::is_same_v<T, signed char> || std::is_same_v<T, unsigned char>)
+			v.kind = Value::Kind::Char, v.i = x;
+		else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+			v.kind = Value::Kind::Signed, v.i = x;
+		else if constexpr (std::is_integral_v<T>)
+			v.kind = Value::Kind::Unsigned, v.u = x;
+		else if constexpr (std::is_enum_v<T> && std::is_convertible_v<T, long long>)
+			return describe(+x);
+		else if constexpr (std::is_floating_point_v<T>)
+			v.kind = Value::Kind::Float, v.f = double(x);
+		else if constexpr (std::is_null_pointer_v<T>)
+			v.kind = Value::Kind::String, v.s = "nullptr";
+		else if constexpr (std::is_convertible_v<const T&, const char*>)
+		{
+			const char* s = x;
+			if (s)
+				v.kind = Value::Kind::String, v.s = s;
+			else
+				v.kind = Value::Kind::Pointer;
+		}
+		else if constexpr (std::is_pointer_v<std::decay_t<T>> && std::is_object_v<std::remove_pointer_t<std::decay_t<T>>>)
+			v.kind = Value::Kind::Pointer, v.p = const_cast<const void*>(static_cast<const volatile void*>(x));
+		else if constexpr (std::is_convertible_v<const T&, std::string_view>)
+			v.kind = Value::Kind::String, v.s = x;
+		else
+			v.s = typeid(T).name();
+		return v;
+	}
+
+	template <class A, class B, Op OP>
+	struct Comparison
+	{
+		const A& a;
+		const B& b;
+
+		explicit operator bool() const
+		{
+			if constexpr (OP == Op::EQ) return bool(a == b);
+			if constexpr (OP == Op::NE) return bool(a != b);
+			if constexpr (OP == Op::SL) return bool(a <  b);
+			if constexpr (OP == Op::LE) return bool(a <= b);
+			if constexpr (OP == Op::SG) return bool(a >  b);
+			if constexpr (OP == Op::GE) return bool(a >= b);
+		}
+	};
+
+	template <class T>
+	struct Operand
+	{
+		const T& value;
+
+		explicit operator bool() const { return bool(value); }
+
+		template <class B> Comparison<T, B, Op::EQ> operator==(const B& b) const { return { value, b }; }
+		template <class B> Comparison<T, B, Op::NE> operator!=(const B& b) const { return { value, b }; }
+		template <class B> Comparison<T, B, Op::SL> operator< (const B& b) const { return { value, b }; }
+		template <class B> Comparison<T, B, Op::LE> operator<=(const B& b) const { return { value, b }; }
+		template <class B> Comparison<T, B, Op::SG> operator> (const B& b) const { return { value, b }; }
+		template <class B> Comparison<T, B, Op::GE> operator>=(const B& b) const { return { value, b }; }
+	};
+
+	struct Split { };
+	static constexpr Split split = {};
+
+	template <class T>
+	Operand<T> operator<<(Split, const T& value) { return { value }; }
+
+	// Non-owning reference to a callable
+	class ProcedureRef
+	{
+		void* _callable;
+		void (*_call)(void*);
+	public:
+		template <class Proc, class = std::enable_if_t<!std::is_same_v<std::decay_t<Proc>, ProcedureRef>>>
+		ProcedureRef(Proc&& proc) 
+			: _callable(const_cast<void*>(static_cast<const void*>(&proc)))
+			, _call([](void* callable) { (*static_cast<std::remove_reference_t<Proc>*>(callable))(); })
+		{ }
+
+		void operator()() const { _call(_callable); }
+	};
+
+	void increaseCount(const Assertion& info);
+	void fail(const Assertion& info, const Value& value);
+	void fail(const Assertion& info, const Value& a, Op op, const Value& b);
+	void check_approx(const Assertion& info, double a, Op op, double b);
+	void check_noexcept(const Assertion& info, ProcedureRef test);
+
+	template <class T>
+	void check(const Assertion& info, const Operand<T>& result)
+	{
+		increaseCount(info);
+		if (!result)
+			fail(info, describe(result.value));
+	}
+	// For expressions whose operands the capture does not reach, like a && b
+	inline void check(const Assertion& info, bool result)
+	{
+		increaseCount(info);
+		if (!result)
+			fail(info, describe(result));
+	}
+	template <class A, class B, Op OP>
+	void check(const Assertion& info, const Comparison<A, B, OP>& result)
+	{
+		increaseCount(info);
+		if (!result)
+			fail(info, describe(result.a), OP, describe(result.b));
+	}
+	template <class A, class B, Op OP>
+	void check_approx(const Assertion& info, const Comparison<A, B, OP>& result)
+	{
+		static_assert(std::is_arithmetic_v<A> && std::is_arithmetic_v<B>, "use tester.h to approximate other types");
+		static_assert(OP == Op::EQ || OP == Op::NE, "only == and != can be approximated");
+		check_approx(info, double(result.a), OP, double(result.b));
+	}
+
+	class Case
+	{
+		const char* _name;
+		const char* _tags;
+		double _timeout;
+	public:
+		Case(const char* name, const char* tags = "", double timeout = 0) : _name(name), _tags(tags), _timeout(timeout) { }
+
+		Case operator<<(void (*proc)()) && ;
+	};
+
+	class Subcase
+	{
+		const bool _shall_enter;
+	public:
+		Subcase(std::string_view name);
+		~Subcase();
+
+		template <class Proc>
+		void operator<<(Proc&& procedure) const { if (_shall_enter) enter(procedure); }
+	private:
+		static void enter(ProcedureRef procedure);
+	};
+
+	class Repeat
+	{
+		size_t _count;
+	public:
+		Repeat(size_t count) : _count(count) { }
+
+		template <class Proc>
+		void operator<<(Proc&& procedure) const { run(procedure); }
+	private:
+		void run(ProcedureRef procedure) const;
+	};
+}
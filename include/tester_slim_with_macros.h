@@ -0,0 +1,8 @@
+#pragma once
+
+#include "tester_slim_with_prefix_macros.h"
+
+#define TEST_CASE(...) TESTER_TEST_CASE(__VA_ARGS__)
+#define CHECK_NOEXCEPT(expr) TESTER_CHECK_NOEXCEPT(expr)
+#define CHECK(expr) TESTER_CHECK(expr)
+#define CHECK_APPROX(expr) TESTER_CHECK_APPROX(expr)
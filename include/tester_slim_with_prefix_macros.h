@@ -0,0 +1,14 @@
+#pragma once
+
+#include "tester_slim.h"
+
+namespace tester
+{
+	// Lets tests name tester::Subcase and tester::Repeat with either header
+	using namespace slim;
+}
+
+#define TESTER_CHECK_NOEXCEPT(expr) ::tester::slim::check_noexcept({ __FILE__, __LINE__, #expr }, [&] { expr; })
+#define TESTER_CHECK(expr) ::tester::slim::check({ __FILE__, __LINE__, #expr }, ::tester::slim::split << expr)
+#define TESTER_CHECK_APPROX(expr) ::tester::slim::check_approx({ __FILE__, __LINE__, #expr }, ::tester::slim::split << expr)
+#define TESTER_TEST_CASE(...) TESTER_CASE_ENTRY(TESTER_PASTE(_test_case_, __COUNTER__), false, __VA_ARGS__)
@@ -2,9 +2,16 @@
 
 #include "tester_with_prefix_macros.h"
 
-#define TEST_CASE(name) TESTER_TEST_CASE(name)
+#define TEST_CASE(...) TESTER_TEST_CASE(__VA_ARGS__)
 #define CHECK_NOEXCEPT(expr) TESTER_CHECK_NOEXCEPT(expr)
 #define CHECK(expr) TESTER_CHECK(expr)
 #define CHECK_APPROX(expr) TESTER_CHECK_APPROX(expr)
 #define CHECK_EACH(expr) TESTER_CHECK_EACH(expr)
 #define CHECK_EACH_APPROX(expr) TESTER_CHECK_EACH_APPROX(expr)
+#define CHECK_NO_ALLOC(expr) TESTER_CHECK_NO_ALLOC(expr)
+#define NO_ALLOC_SCOPE() TESTER_NO_ALLOC_SCOPE()
+#define CHECK_PERF(name, ...) TESTER_CHECK_PERF(name, __VA_ARGS__)
+#define CHECK_PERCENTILE_BELOW(latency, percent, limit) TESTER_CHECK_PERCENTILE_BELOW(latency, percent, limit)
+#define PROPERTY(name, ...) TESTER_PROPERTY(name, __VA_ARGS__)
+#define BENCHMARK(...) TESTER_BENCHMARK(__VA_ARGS__)
+#define FUZZ_CASE(...) TESTER_FUZZ_CASE(__VA_ARGS__)
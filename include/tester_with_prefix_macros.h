@@ -1,13 +1,19 @@
 #pragma once
 
 #include "tester.h"
-
-#define TESTER_PASTE_IMPL(a, b) a ## b
-#define TESTER_PASTE(a, b) TESTER_PASTE_IMPL(a, b)
+#include "tester_property.h"
 
 #define TESTER_CHECK_NOEXCEPT(expr) ::tester::check_noexcept({ __FILE__, __LINE__, #expr }, [&] { expr; })
 #define TESTER_CHECK(expr) ::tester::check({ __FILE__, __LINE__, #expr }, ::tester::split << expr)
 #define TESTER_CHECK_APPROX(expr) ::tester::check_approx({ __FILE__, __LINE__, #expr }, ::tester::split << expr)
 #define TESTER_CHECK_EACH(expr) ::tester::check_each({ __FILE__, __LINE__, #expr }, ::tester::split << expr)
 #define TESTER_CHECK_EACH_APPROX(expr) ::tester::check_each_approx({ __FILE__, __LINE__, #expr }, ::tester::split << expr)
-#define TESTER_TEST_CASE(name) static const auto TESTER_PASTE(_test_case_, __COUNTER__) = ::tester::Case(name) << []
+#define TESTER_CHECK_NO_ALLOC(expr) ::tester::check_no_alloc({ __FILE__, __LINE__, #expr }, [&] { expr; })
+#define TESTER_NO_ALLOC_SCOPE() const ::tester::NoAllocScope TESTER_PASTE(_no_alloc_scope_, __COUNTER__)({ __FILE__, __LINE__, "no allocations in scope" })
+#define TESTER_CHECK_PERF(name, ...) ::tester::check_perf({ __FILE__, __LINE__, name }, [&] { __VA_ARGS__; })
+#define TESTER_CHECK_PERCENTILE_BELOW(latency, percent, limit) ::tester::check_percentile_below({ __FILE__, __LINE__, "p" #percent " of " #latency " < " #limit }, latency, percent, limit)
+#define TESTER_PROPERTY(name, ...) ::tester::Property({ __FILE__, __LINE__, name }, __VA_ARGS__) << [&]
+#define TESTER_FUZZ_CASE(...) static const auto TESTER_PASTE(_test_case_, __COUNTER__) = ::tester::FuzzCase(__VA_ARGS__) << [](::tester::Bytes input)
+
+#define TESTER_TEST_CASE(...) TESTER_CASE_ENTRY(TESTER_PASTE(_test_case_, __COUNTER__), false, __VA_ARGS__)
+#define TESTER_BENCHMARK(...) TESTER_CASE_ENTRY(TESTER_PASTE(_test_case_, __COUNTER__), true, __VA_ARGS__)
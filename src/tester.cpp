@@ -1,10 +1,63 @@
 #include "tester.h"
+#include "tester_reporters.h"
+#include "tester_slim.h"
+#include "tester_property.h"
 
 #include <vector>
+#include <unordered_map>
+#include <tuple>
 #include <optional>
 #include <chrono>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <fstream>
+#include <filesystem>
+#include <regex>
+#include <random>
+#include <algorithm>
+#include <iostream>
+#include <system_error>
+#include <cstring>
+#include <charconv>
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
 
+#ifndef _WIN32
+#include <csignal>
+#include <cerrno>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <time.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <sys/prctl.h>
+#endif
+
+#if __has_include("../base/gsl.h")
 #include "../base/gsl.h"
+#else
+// Built on its own, outside the project that provides the contract checks
+#include <cassert>
+#define Expects(cond) assert(cond)
+#endif
+
+#if defined(__ELF__)
+// Bounds of the section TESTER_CASE_ENTRY places entries in, null when the binary defines no cases
+extern "C" const tester::CaseEntry __start_tester_cases[] __attribute__((weak, visibility("hidden")));
+extern "C" const tester::CaseEntry __stop_tester_cases[] __attribute__((weak, visibility("hidden")));
+#endif
 
 namespace tester
 {
@@ -16,44 +69,453 @@ namespace tester
 	{
 		const char* name;
 		Procedure proc;
+		const char* tags;
+		// Seconds, 0 means RunOptions::case_timeout
+		double timeout = 0;
+		// Known for cases defined with the macros
+		const char* file = nullptr;
+		unsigned line = 0;
 	};
 	static auto& cases()
 	{
 		static std::vector<CaseData> data; 
 		return data;
 	}
+
+	Span<const CaseEntry> caseTable()
+	{
+#if defined(__ELF__)
+		if (__start_tester_cases && __stop_tester_cases)
+			return { __start_tester_cases, size_t(__stop_tester_cases - __start_tester_cases) };
+#endif
+		return {};
+	}
+	static CaseData case_data(const CaseEntry& entry)
+	{
+		Procedure proc = entry.proc;
+		if (entry.benchmark)
+			proc = [proc = entry.proc] { Benchmark("") << proc; };
+		return { entry.name, std::move(proc), entry.tags, entry.timeout, entry.file, entry.line };
+	}
+	int registerCase(const CaseEntry& entry)
+	{
+		cases().push_back(case_data(entry));
+		return 0;
+	}
+	// Puts the cases of the table before the ones registered at startup, ordered by file and line,
+	// since the linker keeps no particular order
+	static void load_case_table()
+	{
+		static bool loaded = false;
+		if (loaded)
+			return;
+		loaded = true;
+		std::vector<const CaseEntry*> entries;
+		for (auto& entry : caseTable())
+			entries.push_back(&entry);
+		std::stable_sort(entries.begin(), entries.end(), [](auto a, auto b)
+		{
+			const auto order = std::strcmp(a->file, b->file);
+			return order != 0 ? order < 0 : a->line < b->line;
+		});
+		std::vector<CaseData> table;
+		for (auto entry : entries)
+			table.push_back(case_data(*entry));
+		cases().insert(cases().begin(), std::make_move_iterator(table.begin()), std::make_move_iterator(table.end()));
+	}
+	// SubcaseData::iteration when the section is not a Repeat iteration
+	static constexpr size_t no_iteration = size_t(-1);
+	// SubcaseData::node until the level is entered
+	static constexpr uint32_t no_node = uint32_t(-1);
+	// Subcase levels and tree nodes reserved on each thread, beyond which entering a subcase grows them
+	static constexpr size_t reserved_depth = 16;
+	static constexpr size_t reserved_nodes = 256;
+
 	static auto& subcase_stack()
 	{
 		struct AssertData
 		{
 			std::string first_fail;
+			std::string path;
+			const char* file = nullptr;
+			unsigned line = 0;
+			const char* expr = nullptr;
 			size_t fail_count = 0;
+			// Repeat iteration of the first failure
+			size_t iteration = no_iteration;
+		};
+		// Failures are keyed by assertion site, so storage grows with the number of failing sites
+		struct Site
+		{
+			const char* file;
+			unsigned line;
+			const char* expr;
+
+			bool operator==(const Site& other) const { return file == other.file && line == other.line && expr == other.expr; }
+		};
+		struct SiteHash
+		{
+			size_t operator()(const Site& site) const 
+			{ 
+				const auto h = std::hash<const void*>{};
+				return h(site.file) ^ (h(site.expr) * 31) ^ (size_t(site.line) * 0x9e3779b97f4a7c15ull);
+			}
 		};
 		struct SubcaseData
 		{
-			std::string name;
+			// In subcase_tree()
+			uint32_t node = no_node;
 			std::string section;
+			// Section of a Repeat iteration, formatted only when printed
+			size_t iteration = no_iteration;
 			size_t child_count = 0;
 			size_t child_index = 0;
 			size_t assert_count = 0;
+			// Children left out by RunOptions::subcase_filters, by child index
+			std::vector<bool> excluded;
 			double presicion = 0;
 			std::vector<AssertData> fails;
+			std::unordered_map<Site, size_t, SiteHash> fail_sites;
+			size_t current_fail = 0;
 			AssertData exception;
+			std::vector<BenchmarkStats> benchmarks;
+			// Fixtures built while the subcase ran, with their setup time
+			std::vector<std::pair<std::string_view, Timing>> fixtures;
 
-			void reset() { child_count = 0; assert_count = 0; }
+			// Used when exploring subcases by forking
+			bool entered_child = false;
+
+			void reset() { child_count = 0; assert_count = 0; entered_child = false; }
 		};
-		static std::vector<SubcaseData> data;
+		// Subcase state is per thread so that cases can run in parallel
+		// Reserved so entering a subcase does not grow the stack unless cases nest deeper
+		thread_local std::vector<SubcaseData> data = []
+		{
+			std::vector<SubcaseData> stack;
+			stack.reserve(reserved_depth);
+			return stack;
+		}();
 		return data;
 	}
 	static auto& subcase_depth()
 	{
-		static size_t depth;
+		thread_local size_t depth;
 		return depth;
 	}
+	using SubcaseData = std::decay_t<decltype(subcase_stack().front())>;
+
+	// The subcases of the case running on a thread, kept across the runs of the case
+	// so that each name is stored once and paths are only put together when printed
+	struct SubcaseNode
+	{
+		std::string name;
+		uint32_t parent = no_node;
+		// Children are linked in the order the body reaches them, which is also the order they are run in
+		size_t index = 0;
+		uint32_t first_child = no_node;
+		uint32_t next_sibling = no_node;
+		// The child found last, where the search for the next one starts
+		uint32_t last_child = no_node;
+		// Summed over the runs of the case
+		size_t runs = 0;
+		size_t assert_count = 0;
+		size_t fail_count = 0;
+		// Built when first needed
+		std::string path;
+		uint32_t trace_path = 0;
+	};
+	// Nodes are kept in one vector whose storage is reserved up front and reused from case to case,
+	// so adding a node allocates only past reserved_nodes or for a name too long for the string to hold inline
+	class SubcaseTree
+	{
+		std::vector<SubcaseNode> _nodes;
+	public:
+		SubcaseTree() { _nodes.reserve(reserved_nodes); }
+
+		// Starts the tree of a case, returning the id of its root
+		uint32_t reset(std::string_view name)
+		{
+			_nodes.clear();
+			_nodes.emplace_back().name = name;
+			return 0;
+		}
+
+		SubcaseNode& operator[](uint32_t id) { return _nodes[id]; }
+		const SubcaseNode& operator[](uint32_t id) const { return _nodes[id]; }
+
+		// The child reached at index, added on the first run, or when the body names it differently than before
+		uint32_t child(uint32_t parent, size_t index, std::string_view name)
+		{
+			const auto last = _nodes[parent].last_child;
+			auto previous = no_node;
+			auto id = last != no_node && _nodes[last].index <= index ? last : _nodes[parent].first_child;
+			for (; id != no_node && _nodes[id].index < index; id = _nodes[id].next_sibling)
+				previous = id;
+			if (id == no_node || _nodes[id].index != index || _nodes[id].name != name)
+			{
+				// Linked in place of a child named differently at the same index
+				const auto next = id != no_node && _nodes[id].index == index ? _nodes[id].next_sibling : id;
+				id = uint32_t(_nodes.size());
+				auto& node = _nodes.emplace_back();
+				node.name = name;
+				node.parent = parent;
+				node.index = index;
+				node.next_sibling = next;
+				(previous == no_node ? _nodes[parent].first_child : _nodes[previous].next_sibling) = id;
+			}
+			_nodes[parent].last_child = id;
+			return id;
+		}
+
+		// Names from the root, unnamed subcases are left out
+		const std::string& path(uint32_t id)
+		{
+			auto& node = _nodes[id];
+			if (node.path.empty())
+			{
+				auto path = node.parent == no_node ? std::string() : this->path(node.parent);
+				if (node.parent == no_node || !node.name.empty())
+					path.append("/").append(node.name);
+				_nodes[id].path = std::move(path);
+			}
+			return _nodes[id].path;
+		}
+	};
+	// Set on the workers of a parallel Repeat, which print paths from the tree of the thread they work for
+	static thread_local const SubcaseTree* borrowed_tree = nullptr;
+	static SubcaseTree& subcase_tree()
+	{
+		thread_local SubcaseTree tree;
+		return tree;
+	}
+	static const SubcaseTree& read_subcase_tree()
+	{
+		return borrowed_tree ? *borrowed_tree : subcase_tree();
+	}
+
+	// Assertions from threads other than the one running the case, merged into its current subcase by perform
+	struct details::Inbox
+	{
+		std::mutex mutex;
+		std::vector<SubcaseData> levels;
+		std::atomic<bool> pending = false;
+		// Set once the case is done, threads still holding the inbox then look for the running case again
+		std::atomic<bool> done = false;
+		// The path the other threads print, replaced by the path of the subcase when merged
+		std::string root;
+		double presicion = 0;
+		// Fixtures the case used without being tagged with them, released when it is done
+		std::vector<details::FixtureBase*> fixtures;
+	};
+	// Of the case running on a test thread
+	static thread_local Context case_inbox;
+	// Cases running in this process, for threads that assert without Adopt
+	static std::mutex running_mutex;
+	static std::vector<Context> running_inboxes;
+	// For assertions that belong to no case or cannot be told apart, reported at the end of the run
+	// Marked done, so threads reporting to it look for a running case again on each assertion
+	static const Context& orphan_inbox()
+	{
+		static const Context inbox = []
+		{
+			auto inbox = std::make_shared<details::Inbox>();
+			inbox->root = "/(outside any case)";
+			inbox->presicion = _presicion;
+			inbox->done = true;
+			return inbox;
+		}();
+		return inbox;
+	}
+
+	// The inbox a thread outside the case reports to, and whether it was given by Adopt
+	static thread_local details::Inbox* foreign_inbox = nullptr;
+	static thread_local bool foreign_adopted = false;
+	struct ForeignThread
+	{
+		Context inbox;
+
+		void attach(Context context, bool adopted)
+		{
+			flush();
+			inbox = std::move(context);
+			foreign_inbox = inbox.get();
+			foreign_adopted = adopted;
+			auto& stack = subcase_stack();
+			stack.emplace_back();
+			stack.back().node = subcase_tree().reset(std::string_view(inbox->root).substr(1));
+			stack.back().presicion = inbox->presicion;
+			subcase_depth() = 0;
+		}
+		void flush()
+		{
+			auto& stack = subcase_stack();
+			if (inbox && !stack.empty())
+			{
+				// Nobody collects from a case that is done
+				auto& target = inbox->done.load(std::memory_order_relaxed) ? *orphan_inbox() : *inbox;
+				std::lock_guard lock(target.mutex);
+				for (auto& level : stack)
+					target.levels.push_back(std::move(level));
+				target.pending.store(true, std::memory_order_release);
+			}
+			stack.clear();
+			subcase_depth() = 0;
+			inbox = nullptr;
+			foreign_inbox = nullptr;
+			foreign_adopted = false;
+		}
+		~ForeignThread() { flush(); }
+	};
+	static auto& foreign_thread()
+	{
+		// The stack is created first so that it outlives the flush at thread exit
+		subcase_stack();
+		thread_local ForeignThread data;
+		return data;
+	}
+	static void adopt_running_case()
+	{
+		Context running;
+		{
+			std::lock_guard lock(running_mutex);
+			// With no case or several running, the assertion cannot be given to one, see Adopt
+			running = running_inboxes.size() == 1 ? running_inboxes.front() : orphan_inbox();
+		}
+		if (running.get() == foreign_inbox)
+			return;
+		foreign_thread().attach(std::move(running), false);
+	}
+
+	static bool glob_match(std::string_view pattern, std::string_view text)
+	{
+		size_t p = 0, t = 0;
+		size_t star = std::string_view::npos, resume = 0;
+		while (t < text.size())
+		{
+			if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == text[t]))
+				++p, ++t;
+			else if (p < pattern.size() && pattern[p] == '*')
+				star = p++, resume = t;
+			else if (star != std::string_view::npos)
+				p = star + 1, t = ++resume;
+			else
+				return false;
+		}
+		while (p < pattern.size() && pattern[p] == '*')
+			++p;
+		return p == pattern.size();
+	}
+
+	// RunOptions filters, prepared once per run
+	struct Selection
+	{
+		struct Pattern
+		{
+			bool exclude = false;
+			std::string glob;
+			std::optional<std::regex> regex;
+
+			Pattern(std::string_view text)
+			{
+				if (!text.empty() && text[0] == '~')
+					exclude = true, text.remove_prefix(1);
+				if (text.substr(0, 3) == "re:")
+					regex.emplace(std::string(text.substr(3)));
+				else
+					glob = text;
+			}
+			bool matches(std::string_view text) const
+			{
+				return regex ? std::regex_match(text.begin(), text.end(), *regex) : glob_match(glob, text);
+			}
+		};
+		std::vector<Pattern> cases;
+		std::vector<Pattern> tags;
+		std::vector<std::vector<std::string>> subcases;
+
+		Selection(const RunOptions& options)
+		{
+			for (auto& filter : options.case_filters)
+				cases.emplace_back(filter);
+			for (auto& filter : options.tag_filters)
+				tags.emplace_back(filter);
+			for (std::string_view filter : options.subcase_filters)
+			{
+				if (!filter.empty() && filter[0] == '/')
+					filter.remove_prefix(1);
+				auto& segments = subcases.emplace_back();
+				for (size_t slash = filter.find('/'); ; slash = filter.find('/'))
+				{
+					segments.emplace_back(filter.substr(0, slash));
+					if (slash == std::string_view::npos)
+						break;
+					filter.remove_prefix(slash + 1);
+				}
+			}
+		}
+
+		static bool included(const std::vector<Pattern>& patterns, const std::function<bool(const Pattern&)>& match)
+		{
+			bool any_include = false;
+			bool included = false;
+			for (auto& pattern : patterns)
+			{
+				if (pattern.exclude)
+				{
+					if (match(pattern))
+						return false;
+				}
+				else
+				{
+					any_include = true;
+					included = included || match(pattern);
+				}
+			}
+			return included || !any_include;
+		}
+		bool selects(const CaseData& test) const
+		{
+			const std::string_view tags_text = test.tags;
+			auto has_tag = [&](const Pattern& tag)
+			{
+				for (size_t open = tags_text.find('['); open != std::string_view::npos; open = tags_text.find('[', open + 1))
+				{
+					const auto close = tags_text.find(']', open);
+					if (close != std::string_view::npos && tag.matches(tags_text.substr(open + 1, close - open - 1)))
+						return true;
+				}
+				return false;
+			};
+			return
+				included(cases, [&](const Pattern& p) { return p.matches(test.name); }) &&
+				included(tags, has_tag) &&
+				selects([&](size_t) { return std::string_view(test.name); }, 1);
+		}
+		// Whether the subcase path(0)/.../path(depth - 1), or anything below it, can match a subcase filter
+		template <class Path>
+		bool selects(const Path& path, size_t depth) const
+		{
+			if (subcases.empty())
+				return true;
+			for (auto& segments : subcases)
+			{
+				bool match = true;
+				for (size_t i = 0; match && i < std::min(depth, segments.size()); ++i)
+					match = glob_match(segments[i], path(i));
+				if (match)
+					return true;
+			}
+			return false;
+		}
+	};
+	static const Selection* selection = nullptr;
+
 	//auto& parent_subcase() { return subcase_stack()[subcase_depth() - 1]; }
 	static auto& subcase()
 	{
 		auto& stack = subcase_stack();
+		if (stack.empty() || (foreign_inbox && !foreign_adopted && foreign_inbox->done.load(std::memory_order_relaxed)))
+			adopt_running_case();
 		auto depth = subcase_depth();
 		Expects(depth < stack.size());
 		return stack[depth];
@@ -61,29 +523,303 @@ namespace tester
 
 	static std::ostream& print_stack(std::ostream& out)
 	{
+		const auto& tree = read_subcase_tree();
 		for (auto& subcase : subcase_stack())
 		{
-			out << '/' << subcase.name;
+			// Levels are added before their first subcase is entered
+			if (subcase.node == no_node || (tree[subcase.node].name.empty() && &subcase != &subcase_stack().front()))
+				continue;
+			out << '/' << tree[subcase.node].name;
 			if (!subcase.section.empty())
 				out << ':' << subcase.section;
+			else if (subcase.iteration != no_iteration)
+				out << ':' << subcase.iteration;
 		}
 		return out;
 	}
 
-	bool report_failure()
+	// How far the case running on a thread has come, read by the watchdog when the case is over budget
+	struct Progress
+	{
+		const CaseData* test = nullptr;
+		std::chrono::steady_clock::time_point start;
+		std::chrono::steady_clock::time_point deadline;
+		// The subcase path, updated on entering and leaving subcases
+		std::mutex mutex;
+		std::string path;
+		// The last assertion reached
+		std::atomic<const char*> file = nullptr;
+		std::atomic<unsigned> line = 0;
+		std::atomic<const char*> expr = nullptr;
+	};
+	// Set while the thread runs a case under a watchdog
+	static thread_local Progress* progress = nullptr;
+
+	static void record_path(Progress& p)
+	{
+		std::lock_guard lock(p.mutex);
+		p.path.clear();
+		auto& stack = subcase_stack();
+		auto& tree = subcase_tree();
+		for (size_t i = 0; i <= subcase_depth() && i < stack.size(); ++i)
+		{
+			p.path += '/';
+			if (stack[i].node != no_node)
+				p.path += tree[stack[i].node].name;
+			if (!stack[i].section.empty())
+				p.path += ':' + stack[i].section;
+		}
+	}
+
+	// Trace of every assertion executed, see RunOptions::trace
+	// Threads record into their own buffer, which is appended to the file as a self-contained chunk when full
+	// and when the thread ends, so threads and forked processes share the file without coordinating
+	// Chunk: u32 magic, u32 size of the rest, u32 pid, u32 thread,
+	//   u32 site count, per site u32 line, u32 length, file, u32 length, expression,
+	//   u32 path count, per path u32 length, path,
+	//   u32 event count, per event u64 nanoseconds, u32 site, u32 path with bit 31 set when failed
+	static constexpr uint32_t trace_magic = 0x45435254;
+	static constexpr uint32_t trace_failed = 0x80000000u;
+	static bool tracing = false;
+	static struct
+	{
+		std::FILE* file = nullptr;
+		std::mutex mutex;
+		// Ticks are converted to steady clock nanoseconds from the ones taken at the start and at each flush
+		uint64_t start_ticks = 0;
+		uint64_t start_nanoseconds = 0;
+		// Subcase paths by id, 0 is outside any case
+		std::mutex paths_mutex;
+		std::vector<std::string> paths;
+		std::unordered_map<std::string, uint32_t> path_ids;
+		std::atomic<uint32_t> threads = 0;
+	} trace;
+
+	static inline uint64_t trace_ticks()
+	{
+#if defined(__x86_64__) || defined(__i386__)
+		return __rdtsc();
+#else
+		return uint64_t(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+	}
+	static uint64_t trace_nanoseconds()
+	{
+		return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+	}
+
+	static uint32_t intern_path(std::string path)
+	{
+		std::lock_guard lock(trace.paths_mutex);
+		auto [found, inserted] = trace.path_ids.try_emplace(path, uint32_t(trace.paths.size()));
+		if (inserted)
+			trace.paths.push_back(std::move(path));
+		return found->second;
+	}
+	// Path ids of the subcases entered on this thread
+	static thread_local std::vector<uint32_t> trace_path_ids;
+
+	static uint32_t trace_path(uint32_t node)
+	{
+		auto& tree = subcase_tree();
+		if (tree[node].trace_path == 0)
+			tree[node].trace_path = intern_path(tree.path(node));
+		return tree[node].trace_path;
+	}
+
+	struct TraceEvent
+	{
+		uint64_t ticks;
+		const char* file;
+		const char* expr;
+		unsigned line;
+		uint32_t path;
+	};
+	class TraceBuffer
+	{
+		static constexpr size_t capacity = 1 << 14;
+		std::unique_ptr<TraceEvent[]> _events = std::make_unique<TraceEvent[]>(capacity);
+		size_t _size = 0;
+		const uint32_t _thread = trace.threads++;
+
+		template <class T>
+		static void put(std::string& out, const T& value) { out.append(reinterpret_cast<const char*>(&value), sizeof(value)); }
+		static void put(std::string& out, std::string_view text) { put(out, uint32_t(text.size())); out.append(text); }
+	public:
+		~TraceBuffer() { flush(); }
+
+		void add(const Assertion& info)
+		{
+			if (_size == capacity)
+				flush();
+			_events[_size++] = { trace_ticks(), info.file, info.expr, info.line, trace_path_ids.empty() ? 0 : trace_path_ids.back() };
+		}
+		void fail(const Assertion& info)
+		{
+			if (_size == 0)
+				return;
+			auto& last = _events[_size - 1];
+			if (last.file == info.file && last.line == info.line && last.expr == info.expr)
+				last.path |= trace_failed;
+		}
+		void flush()
+		{
+			if (_size == 0 || !trace.file)
+				return;
+			const auto ticks = trace_ticks();
+			const auto nanoseconds = trace_nanoseconds();
+			const double scale = ticks > trace.start_ticks ?
+				double(nanoseconds - trace.start_nanoseconds) / double(ticks - trace.start_ticks) : 1.0;
+
+			// Sites and paths get ids local to the chunk, runs of the same site are common so the last one is kept at hand
+			struct SiteHash
+			{
+				size_t operator()(const std::tuple<const void*, const void*, unsigned>& site) const
+				{
+					const auto h = std::hash<const void*>{};
+					return h(std::get<0>(site)) ^ (h(std::get<1>(site)) * 31) ^ (size_t(std::get<2>(site)) * 0x9e3779b97f4a7c15ull);
+				}
+			};
+			std::unordered_map<std::tuple<const void*, const void*, unsigned>, uint32_t, SiteHash> site_ids;
+			std::unordered_map<uint32_t, uint32_t> path_ids;
+			std::string sites, paths, events(_size * 16, '\0');
+			const TraceEvent* last = nullptr;
+			uint32_t site = 0;
+			uint32_t last_path = ~0u;
+			uint32_t path = 0;
+			for (size_t i = 0; i < _size; ++i)
+			{
+				auto& event = _events[i];
+				if (!last || event.file != last->file || event.line != last->line || event.expr != last->expr)
+				{
+					auto [found, inserted] = site_ids.try_emplace({ event.file, event.expr, event.line }, uint32_t(site_ids.size()));
+					if (inserted)
+					{
+						put(sites, uint32_t(event.line));
+						put(sites, std::string_view(event.file));
+						put(sites, std::string_view(event.expr));
+					}
+					site = found->second;
+				}
+				last = &event;
+				if ((event.path & ~trace_failed) != last_path)
+				{
+					last_path = event.path & ~trace_failed;
+					auto [found, inserted] = path_ids.try_emplace(last_path, uint32_t(path_ids.size()));
+					if (inserted)
+					{
+						std::lock_guard lock(trace.paths_mutex);
+						put(paths, std::string_view(trace.paths[last_path]));
+					}
+					path = found->second;
+				}
+				const uint64_t nanoseconds = trace.start_nanoseconds + uint64_t(double(event.ticks - trace.start_ticks) * scale);
+				const uint32_t path_flags = path | (event.path & trace_failed);
+				auto out = events.data() + i * 16;
+				std::memcpy(out, &nanoseconds, 8);
+				std::memcpy(out + 8, &site, 4);
+				std::memcpy(out + 12, &path_flags, 4);
+			}
+			std::string chunk;
+#ifdef _WIN32
+			const uint32_t pid = 0;
+#else
+			const uint32_t pid = uint32_t(::getpid());
+#endif
+			put(chunk, pid);
+			put(chunk, _thread);
+			put(chunk, uint32_t(site_ids.size()));
+			chunk += sites;
+			put(chunk, uint32_t(path_ids.size()));
+			chunk += paths;
+			put(chunk, uint32_t(_size));
+			chunk += events;
+			std::string header;
+			put(header, trace_magic);
+			put(header, uint32_t(chunk.size()));
+			chunk.insert(0, header);
+
+			std::lock_guard lock(trace.mutex);
+			std::fwrite(chunk.data(), 1, chunk.size(), trace.file);
+			_size = 0;
+		}
+	};
+	static TraceBuffer& trace_buffer()
+	{
+		thread_local TraceBuffer buffer;
+		return buffer;
+	}
+	static void flush_trace()
+	{
+		if (tracing)
+			trace_buffer().flush();
+	}
+	static void start_trace(const std::string& path)
+	{
+		tracing = !path.empty();
+		if (!tracing)
+			return;
+		if (auto file = std::fopen(path.c_str(), "wb"))
+			std::fclose(file);
+		trace.file = std::fopen(path.c_str(), "ab");
+		if (!trace.file)
+			throw std::system_error(errno, std::generic_category(), "could not open trace " + path);
+		// Unbuffered, so that each chunk is appended by a single write
+		std::setvbuf(trace.file, nullptr, _IONBF, 0);
+		trace.start_ticks = trace_ticks();
+		trace.start_nanoseconds = trace_nanoseconds();
+		if (trace.paths.empty())
+			intern_path({});
+	}
+	static void stop_trace()
+	{
+		if (!tracing)
+			return;
+		trace_buffer().flush();
+		std::fclose(trace.file);
+		trace.file = nullptr;
+		tracing = false;
+	}
+
+	// Nesting depth of details::Silence on this thread, and the failures counted meanwhile
+	static thread_local size_t silence_depth = 0;
+	static thread_local size_t silenced_failures = 0;
+
+	bool report_failure(const Assertion& info)
 	{
+		if (tracing)
+			trace_buffer().fail(info);
+		if (silence_depth > 0)
+		{
+			silenced_failures += 1;
+			return false;
+		}
 		auto& subc = subcase();
-		if (subc.fails.size() < subc.assert_count)
-			subc.fails.resize(subc.assert_count);
-		auto& fail = subc.fails[subc.assert_count - 1];
+		auto [site, inserted] = subc.fail_sites.try_emplace({ info.file, info.line, info.expr }, subc.fails.size());
+		if (inserted)
+			subc.fails.emplace_back();
+		subc.current_fail = site->second;
+		auto& fail = subc.fails[subc.current_fail];
 		fail.fail_count += 1;
-		return fail.fail_count == 1;
+		if (fail.fail_count > 1)
+			return false;
+		fail.iteration = subc.iteration;
+		std::ostringstream path;
+		print_stack(path);
+		fail.path = path.str();
+		fail.file = info.file;
+		fail.line = info.line;
+		fail.expr = info.expr;
+		return true;
 	}
 	static bool report_exception()
 	{
 		auto& fail = subcase().exception;
 		fail.fail_count += 1;
-		return fail.fail_count == 1;
+		if (fail.fail_count > 1)
+			return false;
+		fail.iteration = subcase().iteration;
+		return true;
 	}
 
 	decltype(presicion) presicion(
@@ -109,25 +845,89 @@ namespace tester
 		if (depth < stack.size())
 		{
 			stack[depth].section = std::move(value);
+			stack[depth].iteration = no_iteration;
 			stack[depth].presicion = depth > 0 ? stack[depth - 1].presicion : _presicion;
 		}
 	},
 		[]
 	{
-		return subcase_stack().empty() ? "" : subcase().section;
+		if (subcase_stack().empty())
+			return std::string();
+		auto& subc = subcase();
+		return subc.iteration == no_iteration ? subc.section : std::to_string(subc.iteration);
 	});
 
 
-	struct SubcaseInfo
+	// Merges what threads started by the case reported so far into the current subcase
+	static void collect_threads()
 	{
-		std::string id;
-		size_t assert_count = 0;
-		size_t fail_count   = 0;
-		size_t exception_count = 0;
-	};
+		if (!case_inbox || !case_inbox->pending.load(std::memory_order_acquire))
+			return;
+		std::vector<SubcaseData> levels;
+		{
+			std::lock_guard lock(case_inbox->mutex);
+			levels.swap(case_inbox->levels);
+			case_inbox->pending.store(false, std::memory_order_relaxed);
+		}
+		std::ostringstream out;
+		print_stack(out);
+		const auto path = out.str();
+		const auto& root = case_inbox->root;
+		auto& level = subcase();
+		for (auto& from : levels)
+		{
+			level.assert_count += from.assert_count;
+			for (auto& fail : from.fails)
+			{
+				auto [site, inserted] = level.fail_sites.try_emplace({ fail.file, fail.line, fail.expr }, level.fails.size());
+				if (!inserted)
+				{
+					level.fails[site->second].fail_count += fail.fail_count;
+					continue;
+				}
+				if (fail.first_fail.compare(0, root.size() + 1, root + '\n') == 0)
+					fail.first_fail.replace(0, root.size(), path);
+				fail.path = path;
+				level.fails.push_back(std::move(fail));
+			}
+			for (auto& stats : from.benchmarks)
+				level.benchmarks.push_back(std::move(stats));
+			for (auto& fixture : from.fixtures)
+				level.fixtures.push_back(fixture);
+		}
+	}
 
+	// Failures of threads that reported to no case, as failures of the run
+	static void report_orphans(Reporter& reporter, TestResults& result)
+	{
+		auto& inbox = *orphan_inbox();
+		std::vector<SubcaseData> levels;
+		{
+			std::lock_guard lock(inbox.mutex);
+			levels.swap(inbox.levels);
+			inbox.pending.store(false, std::memory_order_relaxed);
+		}
+		SubcaseData merged;
+		for (auto& level : levels)
+		{
+			result.assert_count += level.assert_count;
+			for (auto& fail : level.fails)
+			{
+				auto [site, inserted] = merged.fail_sites.try_emplace({ fail.file, fail.line, fail.expr }, merged.fails.size());
+				if (inserted)
+					merged.fails.push_back(std::move(fail));
+				else
+					merged.fails[site->second].fail_count += fail.fail_count;
+			}
+		}
+		for (auto& fail : merged.fails)
+		{
+			result.fail_count += 1;
+			reporter.assertionFailed({ fail.path, fail.file, fail.line, fail.expr, fail.first_fail, fail.fail_count });
+		}
+	}
 
-	static void perform(const Procedure& proc)
+	static void perform(ProcedureRef proc)
 	{
 		auto explain_exception = [](std::exception* e)
 		{
@@ -139,152 +939,1784 @@ namespace tester
 				out << "unknown exception thrown after " << subcase().assert_count << " asserts\n";
 			return out.str();
 		};
+		auto record_path = []
+		{
+			std::ostringstream path;
+			print_stack(path);
+			subcase().exception.path = path.str();
+		};
 		try { proc(); }
 		catch (std::exception& e)
 		{
 			if (report_exception())
+			{
 				subcase().exception.first_fail = explain_exception(&e);
+				record_path();
+			}
 		}
 		catch (...)
 		{
 			if (report_exception())
+			{
 				subcase().exception.first_fail = explain_exception(nullptr);
+				record_path();
+			}
 		}
+		collect_threads();
 	}
 
-	static SubcaseInfo runCase(const CaseData& test)
-	{
-		SubcaseInfo result;
-		perform(test.proc);
-
-		auto& stack = subcase_stack();
-
-		for (size_t i = 0; i < stack.size(); ++i)
-		{
-			auto& level = stack[i];
-			result.id += "/" + level.name;
-			result.assert_count += level.assert_count;
-			for (auto& fail : level.fails) if (fail.fail_count > 0)
-			{
-				result.fail_count += 1;
+	Context context() { return case_inbox; }
 
-				report << fail.first_fail;
-				if (fail.fail_count > 1)
-				{
-					report <<
-						"  (first failure, failed " << fail.fail_count << " times)\n";
-				}
-				report << "\n";
-			}
-			if (level.exception.fail_count > 0)
-			{
-				result.exception_count += 1;
-				report << level.exception.first_fail;
-				if (level.exception.fail_count > 1)
-					report << "  (first exception, " << level.exception.fail_count << " exceptions thrown)\n";
-				report << "\n";
-			}
-			level.assert_count = 0;
-			level.fails.clear();
-		}
-		return result;
-	}
-	static void increase_subcase_index()
+	Adopt::Adopt(Context context)
 	{
-		auto& stack = subcase_stack();
-		while (!stack.empty())
-		{
-			auto& back = stack.back();
-			back.child_index += 1;
-			if (back.child_index < back.child_count)
-				return;
-		
-			stack.pop_back();
-		}
-		return;
+		if (context)
+			foreign_thread().attach(std::move(context), true);
 	}
+	Adopt::~Adopt() { foreign_thread().flush(); }
 
-	static bool shall_enter()
+	static auto& fixtures()
 	{
-		auto& stack = subcase_stack();
-		if (subcase_depth() + 1 == stack.size())
-		{
-			const auto p = stack.back().presicion;
-			stack.emplace_back();
-			stack.back().presicion = p;
-		}
-		auto& parent = subcase();
-		return parent.child_index == parent.child_count;
+		static std::vector<details::FixtureBase*> data;
+		return data;
 	}
-
-	Subcase::Subcase(std::string_view name) 
-		: _shall_enter(shall_enter())
+	static bool tagged(const CaseData& test, std::string_view tag)
 	{
-		if (_shall_enter)
-		{
-			subcase_depth() += 1;
-			subcase().name = name;
-			subcase().reset();
-		}
+		const std::string_view tags = test.tags;
+		for (size_t open = tags.find('['); open != std::string_view::npos; open = tags.find('[', open + 1))
+			if (tags.substr(open + 1, tag.size()) == tag && tags.substr(open + 1 + tag.size(), 1) == "]")
+				return true;
+		return false;
 	}
-	Subcase::~Subcase()
+	// Counts the selected cases tagged with each fixture as its users, for the run about to start
+	static void expect_fixtures(const std::vector<size_t>& selected)
 	{
-		if (_shall_enter)
-			subcase_depth() -= 1;
-		subcase().child_count += 1;
+		for (auto fixture : fixtures())
+			fixture->expect(size_t(std::count_if(selected.begin(), selected.end(), [&](size_t i) { return tagged(cases()[i], fixture->name()); })));
 	}
-	void Assertion::increaseCount()
+	// Tears down the fixtures this process built, whoever still uses them
+	static void tear_down_fixtures()
 	{
-		subcase().assert_count += 1;
+		for (auto fixture : fixtures())
+			fixture->reset();
 	}
 
-	TestResults runTests()
+	// Makes the case the one that threads it starts report to
+	class RunningCase
+	{
+		const CaseData& _test;
+	public:
+		RunningCase(const CaseData& test) : _test(test)
+		{
+			case_inbox = std::make_shared<details::Inbox>();
+			case_inbox->root = '/' + std::string(test.name);
+			case_inbox->presicion = _presicion;
+			std::lock_guard lock(running_mutex);
+			running_inboxes.push_back(case_inbox);
+		}
+		~RunningCase()
+		{
+			case_inbox->done.store(true, std::memory_order_relaxed);
+			{
+				std::lock_guard lock(running_mutex);
+				running_inboxes.erase(std::find(running_inboxes.begin(), running_inboxes.end(), case_inbox));
+			}
+			std::vector<details::FixtureBase*> held;
+			{
+				std::lock_guard lock(case_inbox->mutex);
+				held.swap(case_inbox->fixtures);
+			}
+			for (auto fixture : held)
+				fixture->release();
+			for (auto fixture : fixtures())
+				if (tagged(_test, fixture->name()))
+					fixture->release();
+			case_inbox = nullptr;
+		}
+	};
+
+#ifdef __linux__
+	// Hardware counters of the calling thread, in a single perf event group
+	// Left closed when perf events are not permitted
+	class PerfCounters
+	{
+		static constexpr size_t count = 4;
+		int _fds[count] = { -1, -1, -1, -1 };
+		pid_t _owner = 0;
+
+		void open()
+		{
+			static constexpr uint64_t configs[count] = 
+			{ 
+				PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES 
+			};
+			_owner = ::getpid();
+			for (size_t i = 0; i < count; ++i)
+			{
+				perf_event_attr attr = {};
+				attr.size = sizeof(attr);
+				attr.type = PERF_TYPE_HARDWARE;
+				attr.config = configs[i];
+				attr.disabled = i == 0;
+				attr.exclude_kernel = 1;
+				attr.exclude_hv = 1;
+				attr.read_format = PERF_FORMAT_GROUP;
+				_fds[i] = int(::syscall(SYS_perf_event_open, &attr, 0, -1, i == 0 ? -1 : _fds[0], 0));
+				if (_fds[i] < 0)
+				{
+					close();
+					return;
+				}
+			}
+			::ioctl(_fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+		}
+		void close()
+		{
+			for (auto& fd : _fds) if (fd >= 0)
+			{
+				::close(fd);
+				fd = -1;
+			}
+		}
+	public:
+		PerfCounters() { open(); }
+		~PerfCounters() { close(); }
+
+		bool read(Timing& timing)
+		{
+			// Counters opened before a fork belong to the parent
+			if (_owner != ::getpid())
+			{
+				close();
+				open();
+			}
+			if (_fds[0] < 0)
+				return false;
+			uint64_t values[1 + count];
+			if (::read(_fds[0], values, sizeof(values)) != sizeof(values) || values[0] != count)
+				return false;
+			timing.counters = true;
+			timing.cycles = values[1];
+			timing.instructions = values[2];
+			timing.cache_misses = values[3];
+			timing.branch_misses = values[4];
+			return true;
+		}
+	};
+#endif
+
+	// Current readings, only meaningful as differences
+	static Timing read_timing()
+	{
+		Timing timing;
+		timing.wall = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#ifndef _WIN32
+		timespec cpu;
+		::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu);
+		timing.cpu = double(cpu.tv_sec) + double(cpu.tv_nsec) * 1e-9;
+#else
+		timing.cpu = double(std::clock()) / CLOCKS_PER_SEC;
+#endif
+#ifdef __linux__
+		thread_local PerfCounters counters;
+		counters.read(timing);
+#endif
+		return timing;
+	}
+	static Timing elapsed_since(const Timing& start)
+	{
+		auto timing = read_timing();
+		timing.wall -= start.wall;
+		timing.cpu -= start.cpu;
+		timing.counters = timing.counters && start.counters;
+		timing.cycles -= start.cycles;
+		timing.instructions -= start.instructions;
+		timing.cache_misses -= start.cache_misses;
+		timing.branch_misses -= start.branch_misses;
+		if (!timing.counters)
+			timing.cycles = timing.instructions = timing.cache_misses = timing.branch_misses = 0;
+		return timing;
+	}
+
+	// Start of the current subcase run
+	static thread_local Timing run_start;
+
+	// The subcase an event on this thread belongs to, taking the running case on other threads like assertions do
+	static SubcaseData* current_subcase()
+	{
+		if (subcase_stack().empty())
+		{
+			std::lock_guard lock(running_mutex);
+			if (running_inboxes.size() != 1)
+				return nullptr;
+		}
+		return &subcase();
+	}
+
+	details::FixtureBase::FixtureBase(const char* name) : _name(name)
+	{
+		fixtures().push_back(this);
+	}
+	details::FixtureBase::~FixtureBase()
+	{
+		fixtures().erase(std::find(fixtures().begin(), fixtures().end(), this));
+	}
+	// Fixtures the case this thread reports to holds already, so using them again takes no lock
+	struct HeldFixtures
+	{
+		// Kept alive, so that a later case cannot get the same address
+		Context inbox;
+		std::vector<const details::FixtureBase*> fixtures;
+	};
+	static thread_local HeldFixtures held_fixtures;
+
+	void details::FixtureBase::acquire()
+	{
+		auto& held_here = held_fixtures;
+		const bool ready = _ready.load(std::memory_order_acquire);
+		if (ready && held_here.inbox.get() == (case_inbox ? case_inbox.get() : foreign_inbox) &&
+			std::find(held_here.fixtures.begin(), held_here.fixtures.end(), this) != held_here.fixtures.end())
+			return;
+
+		// Waiting while another thread builds it is setup time as well
+		const auto start = ready ? Timing() : read_timing();
+		const auto level = current_subcase();
+		const auto inbox = case_inbox ? case_inbox.get() : foreign_inbox;
+
+		std::lock_guard lock(_mutex);
+		if (inbox)
+		{
+			std::lock_guard held(inbox->mutex);
+			if (std::find(inbox->fixtures.begin(), inbox->fixtures.end(), this) == inbox->fixtures.end())
+			{
+				inbox->fixtures.push_back(this);
+				_users += 1;
+			}
+		}
+		if (!_ready.load(std::memory_order_relaxed))
+		{
+			setUp();
+#ifndef _WIN32
+			_owner = ::getpid();
+#endif
+			_ready.store(true, std::memory_order_release);
+			if (level)
+				level->fixtures.emplace_back(_name, elapsed_since(start));
+		}
+		if (!ready && case_inbox)
+		{
+			// Left out of the time of the subcase
+			const auto spent = elapsed_since(start);
+			run_start.wall += spent.wall;
+			run_start.cpu += spent.cpu;
+			run_start.cycles += spent.cycles;
+			run_start.instructions += spent.instructions;
+			run_start.cache_misses += spent.cache_misses;
+			run_start.branch_misses += spent.branch_misses;
+		}
+		if (held_here.inbox.get() != inbox)
+		{
+			held_here.inbox = case_inbox ? case_inbox : foreign_thread().inbox;
+			held_here.fixtures.clear();
+		}
+		held_here.fixtures.push_back(this);
+	}
+	void details::FixtureBase::expect(size_t users)
+	{
+		std::lock_guard lock(_mutex);
+		_users = users;
+	}
+	void details::FixtureBase::release()
+	{
+		std::lock_guard lock(_mutex);
+		if (_users > 0 && --_users == 0 && _ready.load(std::memory_order_relaxed))
+		{
+			tearDown();
+			_ready.store(false, std::memory_order_relaxed);
+		}
+	}
+	void details::FixtureBase::reset()
+	{
+		std::lock_guard lock(_mutex);
+		_users = 0;
+		if (!_ready.load(std::memory_order_relaxed))
+			return;
+#ifndef _WIN32
+		if (_owner != ::getpid())
+			return;
+#endif
+		tearDown();
+		_ready.store(false, std::memory_order_relaxed);
+	}
+
+	namespace details
+	{
+		AllocationCounters& allocation_counters()
+		{
+			thread_local AllocationCounters counters = {};
+			return counters;
+		}
+
+		AllocationMark mark_allocations()
+		{
+			auto& counters = allocation_counters();
+			const AllocationMark mark = { counters.allocations, counters.bytes, counters.record_base };
+			counters.record_base = counters.allocations;
+			return mark;
+		}
+
+		void check_allocations(const Assertion& info, const AllocationMark& mark)
+		{
+			auto& counters = allocation_counters();
+			const auto count = counters.allocations - mark.allocations;
+			const auto bytes = counters.bytes - mark.bytes;
+			const auto recorded = std::min(count, std::size(counters.sizes));
+			size_t sizes[std::extent_v<decltype(AllocationCounters::sizes)>];
+			std::copy(counters.sizes, counters.sizes + recorded, sizes);
+			counters.record_base = mark.record_base;
+			if (count == 0 || !report_failure(info))
+				return;
+
+			Subreport subreport;
+			subreport << info << "failed: allocated " << count << " times, " << bytes << " bytes\n    sizes:";
+			for (size_t i = 0; i < recorded; ++i)
+				subreport << ' ' << sizes[i];
+			if (recorded < count)
+				subreport << " ...";
+			subreport << '\n';
+		}
+	}
+
+	NoAllocScope::NoAllocScope(const Assertion& info) : _info(info), _mark(details::mark_allocations())
+	{
+		_info.increaseCount();
+	}
+	NoAllocScope::~NoAllocScope()
+	{
+		details::check_allocations(_info, _mark);
+	}
+
+	static SubcaseInfo runCase(const CaseData& test, Reporter& reporter)
+	{
+		SubcaseInfo result;
+		auto& allocations = details::allocation_counters();
+		const auto allocations_start = allocations;
+		allocations.peak = allocations.live;
+		if (tracing)
+			trace_path_ids.assign(1, trace_path(0));
+		run_start = read_timing();
+		perform(test.proc);
+		result.timing = elapsed_since(run_start);
+		result.allocations.allocations = allocations.allocations - allocations_start.allocations;
+		result.allocations.bytes = allocations.bytes - allocations_start.bytes;
+		result.allocations.peak = size_t(std::max<ptrdiff_t>(allocations.peak - allocations_start.live, 0));
+
+		auto& stack = subcase_stack();
+		auto& tree = subcase_tree();
+
+		auto deepest = no_node;
+		for (size_t i = 0; i < stack.size(); ++i)
+		{
+			auto& level = stack[i];
+			// The last level is left unentered when all its subcases were skipped
+			if (level.node == no_node)
+				continue;
+			auto& node = tree[level.node];
+			node.runs += 1;
+			node.assert_count += level.assert_count;
+			node.fail_count += level.fails.size();
+			deepest = level.node;
+			result.assert_count += level.assert_count;
+			for (auto& fail : level.fails)
+			{
+				result.fail_count += 1;
+				reporter.assertionFailed({ fail.path, fail.file, fail.line, fail.expr, fail.first_fail, fail.fail_count });
+			}
+			if (level.exception.fail_count > 0)
+			{
+				result.exception_count += 1;
+				reporter.exceptionThrown({ level.exception.path, "", 0, "", level.exception.first_fail, level.exception.fail_count });
+			}
+			for (auto& stats : level.benchmarks)
+			{
+				result.benchmark_count += 1;
+				reporter.benchmarkDone(stats);
+			}
+			for (auto& [name, timing] : level.fixtures)
+				reporter.fixtureSetUp(name, timing);
+			level.assert_count = 0;
+			level.fails.clear();
+			level.fail_sites.clear();
+			level.benchmarks.clear();
+			level.fixtures.clear();
+		}
+		if (deepest != no_node)
+			result.id = tree.path(deepest);
+		return result;
+	}
+	static void increase_subcase_index()
+	{
+		auto& stack = subcase_stack();
+		while (!stack.empty())
+		{
+			auto& back = stack.back();
+			back.child_index += 1;
+			while (back.child_index < back.child_count && back.child_index < back.excluded.size() && back.excluded[back.child_index])
+				back.child_index += 1;
+			if (back.child_index < back.child_count)
+				return;
+		
+			stack.pop_back();
+		}
+		return;
+	}
+
+	static bool selected(std::string_view name)
+	{
+		if (!selection)
+			return true;
+		auto& stack = subcase_stack();
+		const auto depth = subcase_depth();
+		auto& tree = subcase_tree();
+		return selection->selects([&](size_t i) -> std::string_view { return i > depth ? name : std::string_view(tree[stack[i].node].name); }, depth + 2);
+	}
+
+#ifndef _WIN32
+	// Set for the duration of a run with RunOptions::fork_subcases
+	static bool fork_subcases = false;
+	static bool explore_branch(std::string_view name);
+	static TestResults exploreTest(const CaseData& test, Reporter& reporter);
+#endif
+
+	static bool shall_enter(std::string_view name)
+	{
+		auto& stack = subcase_stack();
+		if (subcase_depth() + 1 == stack.size())
+		{
+			const auto p = stack.back().presicion;
+			stack.emplace_back();
+			stack.back().presicion = p;
+		}
+		auto& parent = subcase();
+		if (!selected(name))
+		{
+			// Skip the branch, remembering it so later runs are not spent on it
+			if (parent.excluded.size() <= parent.child_count)
+				parent.excluded.resize(parent.child_count + 1);
+			parent.excluded[parent.child_count] = true;
+			if (parent.child_index == parent.child_count)
+				parent.child_index += 1;
+			return false;
+		}
+#ifndef _WIN32
+		if (fork_subcases)
+		{
+			if (parent.entered_child)
+				return false;
+			parent.entered_child = explore_branch(name);
+			return parent.entered_child;
+		}
+#endif
+		return parent.child_index == parent.child_count;
+	}
+
+	static bool begin_subcase(std::string_view name)
+	{
+		// Workers of a parallel Repeat only read the subcase tree of the thread running the case
+		if (borrowed_tree)
+			throw std::logic_error("subcase " + std::string(name) + " in the body of a parallel Repeat, which cannot have subcases");
+		if (!shall_enter(name))
+			return false;
+		auto& parent = subcase();
+		const auto node = subcase_tree().child(parent.node, parent.child_count, name);
+		subcase_depth() += 1;
+		subcase().node = node;
+		subcase().reset();
+		if (progress)
+			record_path(*progress);
+		if (tracing && !trace_path_ids.empty())
+			trace_path_ids.push_back(trace_path(node));
+		return true;
+	}
+	static void end_subcase(bool entered)
+	{
+		if (entered)
+		{
+			subcase_depth() -= 1;
+			if (progress)
+				record_path(*progress);
+			if (tracing && trace_path_ids.size() > 1)
+				trace_path_ids.pop_back();
+		}
+		subcase().child_count += 1;
+	}
+
+	Subcase::Subcase(std::string_view name) : _shall_enter(begin_subcase(name)) { }
+	Subcase::~Subcase() { end_subcase(_shall_enter); }
+	void Assertion::increaseCount() const
+	{
+		if (progress)
+		{
+			progress->file.store(file, std::memory_order_relaxed);
+			progress->line.store(line, std::memory_order_relaxed);
+			progress->expr.store(expr, std::memory_order_relaxed);
+		}
+		if (tracing)
+			trace_buffer().add(*this);
+		if (silence_depth == 0)
+			subcase().assert_count += 1;
+	}
+
+	static size_t property_trials = 100;
+	static uint64_t property_seed = 0;
+	static size_t mismatch_limit = 10;
+	static std::string fuzz_corpus;
+
+	namespace details
+	{
+		Silence::Silence() : _failures(silenced_failures) { silence_depth += 1; }
+		Silence::~Silence() { silence_depth -= 1; }
+		size_t Silence::failures() const { return silenced_failures - _failures; }
+
+		size_t property_trials() { return tester::property_trials; }
+		uint64_t property_seed() { return tester::property_seed; }
+		size_t mismatch_limit() { return tester::mismatch_limit; }
+
+		void Mismatches::add(size_t i, size_t limit)
+		{
+			if (count == 0 || i != last + 1)
+			{
+				range_count += 1;
+				if (ranges.size() < limit)
+					ranges.emplace_back(i, i + 1);
+			}
+			else if (range_count == ranges.size())
+				ranges.back().second = i + 1;
+			if (count == 0)
+				first = i;
+			last = i;
+			count += 1;
+		}
+		void Mismatches::error(size_t i, double a, double b)
+		{
+			const double abs = std::abs(a - b);
+			const double rel = abs / std::max(std::abs(a), std::abs(b));
+			if (!has_error || abs > max_abs)
+				max_abs = abs, max_abs_index = i;
+			if (!has_error || rel > max_rel)
+				max_rel = rel, max_rel_index = i;
+			has_error = true;
+		}
+		std::ostream& operator<<(std::ostream& out, const Mismatches& mismatches)
+		{
+			out << "... " << mismatches.count << " mismatches in " << mismatches.range_count << " ranges, from index "
+				<< mismatches.first << " to " << mismatches.last << ":\n   ";
+			for (auto [begin, end] : mismatches.ranges)
+				out << " [" << begin << ", " << end << ')';
+			if (mismatches.range_count > mismatches.ranges.size())
+				out << " and " << mismatches.range_count - mismatches.ranges.size() << " more";
+			out << '\n';
+			if (mismatches.has_error)
+				out << "    max absolute error " << mismatches.max_abs << " at index " << mismatches.max_abs_index
+					<< ", max relative error " << mismatches.max_rel << " at index " << mismatches.max_rel_index << '\n';
+			return out;
+		}
+	}
+
+	// Watches the cases running in this process for overruns of their time budgets
+	class Watchdog
+	{
+	public:
+		using Clock = std::chrono::steady_clock;
+		// Called with the cases over budget, or with all running cases when the whole run is over budget
+		// Must not return, the threads running those cases are still inside them
+		using Expired = std::function<void(const std::vector<Progress*>& cases, bool run_expired)>;
+	private:
+		std::mutex _mutex;
+		std::condition_variable _wake;
+		std::vector<Progress*> _running;
+		Clock::time_point _run_deadline;
+		Expired _expired;
+		bool _stop = false;
+		std::thread _thread;
+
+		void watch()
+		{
+			std::unique_lock lock(_mutex);
+			while (!_stop)
+			{
+				auto next = _run_deadline;
+				for (auto p : _running)
+					next = std::min(next, p->deadline);
+				const auto now = Clock::now();
+				if (next == Clock::time_point::max())
+				{
+					_wake.wait(lock);
+					continue;
+				}
+				if (next > now)
+				{
+					_wake.wait_until(lock, next);
+					continue;
+				}
+				const bool run_expired = _run_deadline <= now;
+				std::vector<Progress*> overrun;
+				for (auto p : _running)
+					if (run_expired || p->deadline <= now)
+						overrun.push_back(p);
+				_expired(overrun, run_expired);
+				std::abort();
+			}
+		}
+	public:
+		static Clock::time_point deadline(double seconds)
+		{
+			if (seconds <= 0)
+				return Clock::time_point::max();
+			return Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+		}
+
+		Watchdog(double run_budget, Expired expired) 
+			: _run_deadline(deadline(run_budget)), _expired(std::move(expired)), _thread([this] { watch(); }) { }
+		~Watchdog()
+		{
+			{
+				std::lock_guard lock(_mutex);
+				_stop = true;
+			}
+			_wake.notify_all();
+			_thread.join();
+		}
+
+		void add(Progress& p)
+		{
+			{
+				std::lock_guard lock(_mutex);
+				_running.push_back(&p);
+			}
+			_wake.notify_all();
+		}
+		void remove(Progress& p)
+		{
+			std::lock_guard lock(_mutex);
+			_running.erase(std::find(_running.begin(), _running.end(), &p));
+		}
+	};
+	// Set while cases run with time budgets
+	static Watchdog* watchdog = nullptr;
+	static double case_timeout = 0;
+
+	// Registers the case running on this thread with the watchdog
+	class Watch
+	{
+		Progress _progress;
+	public:
+		Watch(const CaseData& test)
+		{
+			_progress.test = &test;
+			_progress.start = Watchdog::Clock::now();
+			_progress.deadline = Watchdog::deadline(test.timeout > 0 ? test.timeout : case_timeout);
+			_progress.path = std::string("/") + test.name;
+			progress = &_progress;
+			watchdog->add(_progress);
+		}
+		~Watch()
+		{
+			watchdog->remove(_progress);
+			progress = nullptr;
+		}
+	};
+
+	static Failure describe_timeout(Progress& p, bool run_expired)
+	{
+		std::lock_guard lock(p.mutex);
+		const std::chrono::duration<double> elapsed = Watchdog::Clock::now() - p.start;
+		std::ostringstream message;
+		message << p.path << '\n' << (run_expired ? "run" : "case") << " timed out after " << elapsed.count() << "s, ";
+		if (const auto file = p.file.load())
+			message << "last assertion reached:\n" << file << '(' << p.line.load() << ')' << '\n' << "    " << p.expr.load() << '\n';
+		else
+			message << "before any assertion\n";
+		return { p.path, "", 0, "", message.str(), 1 };
+	}
+
+	static TestResults runTest(const CaseData& test, Reporter& reporter)
+	{
+		std::optional<Watch> watch;
+		if (watchdog)
+			watch.emplace(test);
+		RunningCase running(test);
+#ifndef _WIN32
+		if (fork_subcases)
+			return exploreTest(test, reporter);
+#endif
+		TestResults result;
+		reporter.caseStarted(test.name);
+		Expects(subcase_stack().empty());
+		subcase_stack().emplace_back();
+		subcase().node = subcase_tree().reset(test.name);
+		subcase().presicion = _presicion;
+		while (!subcase_stack().empty())
+		{
+			result.subcase_count += 1;
+			subcase().reset();
+
+			auto info = runCase(test, reporter);
+			reporter.subcaseDone(info);
+			result.assert_count += info.assert_count;
+			result.fail_count += info.fail_count;
+			result.exception_count += info.exception_count;
+			result.benchmark_count += info.benchmark_count;
+			result.timing += info.timing;
+			result.allocations += info.allocations;
+
+			increase_subcase_index();
+		}
+		reporter.caseDone(test.name, result);
+		return result;
+	}
+
+	// Records events into a byte string, so they can be replayed in order later, possibly by another process
+	class Recorder : public Reporter
+	{
+		enum Event : char { CaseStarted, AssertionFailed, ExceptionThrown, BenchmarkDone, FixtureSetUp, SubcaseDone, CaseDone };
+
+		std::string& _data;
+
+		template <class T>
+		void put(const T& value) { _data.append(reinterpret_cast<const char*>(&value), sizeof(value)); }
+		void put(std::string_view value) { put(value.size()); _data.append(value); }
+		void put(const std::string& value) { put(std::string_view(value)); }
+
+		void putFailure(Event event, const Failure& failure)
+		{
+			put(event);
+			put(failure.path);
+			put(failure.file);
+			put(failure.line);
+			put(failure.expr);
+			put(failure.message);
+			put(failure.count);
+		}
+
+		class Reader
+		{
+			std::string_view _data;
+		public:
+			Reader(std::string_view data) : _data(data) { }
+
+			bool empty() const { return _data.empty(); }
+
+			template <class T>
+			void get(T& value)
+			{
+				Expects(_data.size() >= sizeof(T));
+				std::memcpy(&value, _data.data(), sizeof(T));
+				_data.remove_prefix(sizeof(T));
+			}
+			void get(std::string& value)
+			{
+				size_t size;
+				get(size);
+				Expects(_data.size() >= size);
+				value.assign(_data.data(), size);
+				_data.remove_prefix(size);
+			}
+			void getFailure(Failure& failure)
+			{
+				get(failure.path);
+				get(failure.file);
+				get(failure.line);
+				get(failure.expr);
+				get(failure.message);
+				get(failure.count);
+			}
+		};
+	public:
+		Recorder(std::string& data) : _data(data) { }
+
+		void caseStarted(std::string_view name) override { put(CaseStarted); put(name); }
+		void assertionFailed(const Failure& failure) override { putFailure(AssertionFailed, failure); }
+		void exceptionThrown(const Failure& failure) override { putFailure(ExceptionThrown, failure); }
+		void benchmarkDone(const BenchmarkStats& stats) override
+		{
+			put(BenchmarkDone);
+			put(stats.name);
+			put(stats.iterations);
+			put(stats.samples);
+			put(stats.min);
+			put(stats.median);
+			put(stats.mean);
+			put(stats.mad);
+			put(stats.stddev);
+			put(stats.p90);
+			put(stats.p99);
+			put(stats.p999);
+			put(stats.max);
+		}
+		void fixtureSetUp(std::string_view name, const Timing& timing) override { put(FixtureSetUp); put(name); put(timing); }
+		void subcaseDone(const SubcaseInfo& info) override
+		{
+			put(SubcaseDone);
+			put(info.id);
+			put(info.assert_count);
+			put(info.fail_count);
+			put(info.exception_count);
+			put(info.benchmark_count);
+			put(info.timing);
+			put(info.allocations);
+		}
+		void caseDone(std::string_view name, const TestResults& results) override { put(CaseDone); put(name); put(results); }
+
+		static void replay(std::string_view data, Reporter& reporter)
+		{
+			Reader in(data);
+			std::string name;
+			Failure failure;
+			BenchmarkStats stats;
+			Timing timing;
+			SubcaseInfo info;
+			TestResults results;
+			while (!in.empty())
+			{
+				Event event;
+				in.get(event);
+				switch (event)
+				{
+				case CaseStarted:
+					in.get(name);
+					reporter.caseStarted(name);
+					break;
+				case AssertionFailed:
+					in.getFailure(failure);
+					reporter.assertionFailed(failure);
+					break;
+				case ExceptionThrown:
+					in.getFailure(failure);
+					reporter.exceptionThrown(failure);
+					break;
+				case BenchmarkDone:
+					in.get(stats.name);
+					in.get(stats.iterations);
+					in.get(stats.samples);
+					in.get(stats.min);
+					in.get(stats.median);
+					in.get(stats.mean);
+					in.get(stats.mad);
+					in.get(stats.stddev);
+					in.get(stats.p90);
+					in.get(stats.p99);
+					in.get(stats.p999);
+					in.get(stats.max);
+					reporter.benchmarkDone(stats);
+					break;
+				case FixtureSetUp:
+					in.get(name);
+					in.get(timing);
+					reporter.fixtureSetUp(name, timing);
+					break;
+				case SubcaseDone:
+					in.get(info.id);
+					in.get(info.assert_count);
+					in.get(info.fail_count);
+					in.get(info.exception_count);
+					in.get(info.benchmark_count);
+					in.get(info.timing);
+					in.get(info.allocations);
+					reporter.subcaseDone(info);
+					break;
+				case CaseDone:
+					in.get(name);
+					in.get(results);
+					reporter.caseDone(name, results);
+					break;
+				default:
+					Expects(false);
+				}
+			}
+		}
+	};
+
+	struct Outcome
+	{
+		TestResults result;
+		std::string events;
+	};
+
+	// Held while the reporter of the run is called, by the thread running or delivering cases and by a timeout,
+	// which keeps it until the process exits
+	static std::recursive_mutex reporting;
+
+	// Outcomes of cases run on other threads or processes, delivered in registration order as soon as
+	// each case is done, so output matches a serial run
+	class Deliveries
+	{
+		std::vector<Outcome> _outcomes;
+		std::vector<char> _ready;
+		// Written only by the delivering thread, with reporting held
+		size_t _next = 0;
+		std::mutex _mutex;
+		std::condition_variable _done;
+	public:
+		TestResults result;
+
+		explicit Deliveries(size_t count) : _outcomes(count), _ready(count) { }
+
+		void finish(size_t i, Outcome outcome)
+		{
+			{
+				std::lock_guard lock(_mutex);
+				_outcomes[i] = std::move(outcome);
+				_ready[i] = true;
+			}
+			_done.notify_all();
+		}
+		// Delivers the outcomes from the next one on, up to one not done yet, or all of them when waiting
+		void deliver(Reporter& reporter, bool wait)
+		{
+			while (_next < _ready.size())
+			{
+				{
+					std::unique_lock lock(_mutex);
+					if (wait)
+						_done.wait(lock, [&] { return _ready[_next] != 0; });
+					else if (!_ready[_next])
+						return;
+				}
+				std::lock_guard lock(reporting);
+				Recorder::replay(_outcomes[_next].events, reporter);
+				result += _outcomes[_next].result;
+				_outcomes[_next] = {};
+				_next += 1;
+			}
+		}
+		// For a timeout, with reporting held: delivers every outcome done, skipping the cases still running
+		void deliverDone(Reporter& reporter)
+		{
+			std::lock_guard lock(_mutex);
+			for (size_t i = _next; i < _ready.size(); ++i)
+				if (_ready[i])
+					Recorder::replay(_outcomes[i].events, reporter);
+		}
+	};
+	// The deliveries of the run in progress, if it runs cases on other threads or processes
+	static Deliveries* deliveries = nullptr;
+
+	static TestResults runParallel(const std::vector<size_t>& selected, size_t thread_count, Reporter& reporter)
+	{
+		Deliveries outcomes(selected.size());
+		deliveries = &outcomes;
+		std::atomic<size_t> next = 0;
+
+		auto worker = [&]
+		{
+			for (size_t i = next++; i < selected.size(); i = next++)
+			{
+				Outcome outcome;
+				Recorder recorder(outcome.events);
+				outcome.result = runTest(cases()[selected[i]], recorder);
+				outcomes.finish(i, std::move(outcome));
+			}
+		};
+		std::vector<std::thread> threads;
+		for (size_t i = 0; i < thread_count; ++i)
+			threads.emplace_back(worker);
+
+		outcomes.deliver(reporter, true);
+		for (auto& thread : threads)
+			thread.join();
+		deliveries = nullptr;
+		return outcomes.result;
+	}
+
+#ifndef _WIN32
+	static bool read_all(int fd, void* data, size_t size)
+	{
+		auto p = static_cast<char*>(data);
+		while (size > 0)
+		{
+			const auto n = ::read(fd, p, size);
+			if (n < 0 && errno == EINTR)
+				continue;
+			if (n <= 0)
+				return false;
+			p += n;
+			size -= size_t(n);
+		}
+		return true;
+	}
+	static bool write_all(int fd, const void* data, size_t size)
+	{
+		auto p = static_cast<const char*>(data);
+		while (size > 0)
+		{
+			const auto n = ::write(fd, p, size);
+			if (n < 0 && errno == EINTR)
+				continue;
+			if (n <= 0)
+				return false;
+			p += n;
+			size -= size_t(n);
+		}
+		return true;
+	}
+
+	// Fork exploration of subcases: at each Subcase the process forks, the child enters the subcase
+	// and the parent waits for it before skipping it, so code before a Subcase runs only once
+	// The runs are depth first, in the same order as without forking
+	// Each process that ended up in a leaf appends a record of its run to a shared file
+	static thread_local int exploration_records = -1;
+
+	static void write_record(const TestResults& counts, const std::string& events)
+	{
+		std::string record;
+		const size_t size = events.size();
+		record.append(reinterpret_cast<const char*>(&size), sizeof(size));
+		record.append(reinterpret_cast<const char*>(&counts), sizeof(counts));
+		record.append(events);
+		write_all(exploration_records, record.data(), record.size());
+	}
+
+	static bool explore_branch(std::string_view name)
+	{
+		std::cout.flush();
+		std::cerr.flush();
+		std::fflush(nullptr);
+		// Otherwise both processes would write the events so far
+		flush_trace();
+		const auto so_far = elapsed_since(run_start);
+		const auto pid = ::fork();
+		if (pid < 0)
+			throw std::system_error(errno, std::generic_category(), "fork");
+		if (pid == 0)
+		{
+			// CPU time and counters start over in the child, carry over what the run has used so far
+			run_start = read_timing();
+			run_start.wall -= so_far.wall;
+			run_start.cpu -= so_far.cpu;
+			run_start.counters = run_start.counters && so_far.counters;
+			run_start.cycles -= so_far.cycles;
+			run_start.instructions -= so_far.instructions;
+			run_start.cache_misses -= so_far.cache_misses;
+			run_start.branch_misses -= so_far.branch_misses;
+			return true;
+		}
+
+		int status = 0;
+		while (::waitpid(pid, &status, 0) < 0 && errno == EINTR) { }
+		if (WIFEXITED(status) && WEXITSTATUS(status) == 0)
+			return false;
+
+		std::ostringstream path;
+		print_stack(path) << '/' << name;
+		std::ostringstream message;
+		message << path.str() << '\n';
+		if (WIFSIGNALED(status))
+			message << "subcase process killed by signal " << WTERMSIG(status) << " (" << ::strsignal(WTERMSIG(status)) << ")\n";
+		else
+			message << "subcase process exited with status " << WEXITSTATUS(status) << "\n";
+		SubcaseInfo info;
+		info.id = path.str();
+		info.exception_count = 1;
+		std::string events;
+		Recorder recorder(events);
+		recorder.exceptionThrown({ info.id, "", 0, "", message.str(), 1 });
+		recorder.subcaseDone(info);
+		TestResults counts;
+		counts.subcase_count = 1;
+		counts.exception_count = 1;
+		write_record(counts, events);
+		return false;
+	}
+
+	static TestResults exploreTest(const CaseData& test, Reporter& reporter)
+	{
+		reporter.caseStarted(test.name);
+		Expects(subcase_stack().empty());
+		subcase_stack().emplace_back();
+		subcase().node = subcase_tree().reset(test.name);
+		subcase().presicion = _presicion;
+		subcase().reset();
+
+		const auto records = std::tmpfile();
+		if (!records)
+			throw std::system_error(errno, std::generic_category(), "tmpfile");
+		exploration_records = ::fileno(records);
+		const auto root = ::getpid();
+
+		std::string events;
+		Recorder recorder(events);
+		const auto info = runCase(test, recorder);
+		recorder.subcaseDone(info);
+
+		// A process that skipped every subcase on some level is not a run of its own
+		auto& stack = subcase_stack();
+		const bool leaf = std::none_of(stack.begin(), stack.end(), [](auto& level)
+		{
+			const auto excluded = size_t(std::count(level.excluded.begin(), level.excluded.end(), true));
+			return level.child_count > excluded && !level.entered_child;
+		});
+		if (leaf)
+		{
+			TestResults counts;
+			counts.subcase_count = 1;
+			counts.assert_count = info.assert_count;
+			counts.fail_count = info.fail_count;
+			counts.exception_count = info.exception_count;
+			counts.benchmark_count = info.benchmark_count;
+			counts.timing = info.timing;
+			counts.allocations = info.allocations;
+			write_record(counts, events);
+		}
+		stack.clear();
+		if (::getpid() != root)
+		{
+			tear_down_fixtures();
+			flush_trace();
+			std::cout.flush();
+			std::cerr.flush();
+			std::fflush(nullptr);
+			::_exit(0);
+		}
+
+		TestResults result;
+		::lseek(exploration_records, 0, SEEK_SET);
+		size_t size;
+		while (read_all(exploration_records, &size, sizeof(size)))
+		{
+			TestResults counts;
+			events.resize(size);
+			if (!read_all(exploration_records, &counts, sizeof(counts)) ||
+				!read_all(exploration_records, events.data(), size))
+				break;
+			Recorder::replay(events, reporter);
+			result += counts;
+		}
+		std::fclose(records);
+		exploration_records = -1;
+		reporter.caseDone(test.name, result);
+		return result;
+	}
+
+	// Worker side of the process pool: receives case indices, sends back results and recorded events
+	[[noreturn]] static void serveCases(int in, int out)
+	{
+		// The watchdog of the parent did not survive the fork
+		// A case over budget is sent as its outcome, then the worker exits and is replaced
+		if (watchdog)
+			watchdog = new Watchdog(0, [out](const std::vector<Progress*>& overrun, bool)
+			{
+				const auto name = overrun.front()->test->name;
+				TestResults result;
+				result.subcase_count = 1;
+				result.exception_count = 1;
+				std::string events;
+				Recorder recorder(events);
+				recorder.caseStarted(name);
+				recorder.exceptionThrown(describe_timeout(*overrun.front(), false));
+				recorder.caseDone(name, result);
+				const size_t size = events.size();
+				if (write_all(out, &result, sizeof(result)) && write_all(out, &size, sizeof(size)))
+					write_all(out, events.data(), size);
+				::_exit(timeout_status);
+			});
+		size_t index;
+		while (read_all(in, &index, sizeof(index)))
+		{
+			std::string events;
+			Recorder recorder(events);
+			const auto result = runTest(cases()[index], recorder);
+			const size_t size = events.size();
+			if (!write_all(out, &result, sizeof(result)) ||
+				!write_all(out, &size, sizeof(size)) ||
+				!write_all(out, events.data(), size))
+				break;
+		}
+		tear_down_fixtures();
+		flush_trace();
+		::_exit(0);
+	}
+
+	static TestResults runForked(const std::vector<size_t>& selected, size_t process_count, Reporter& reporter)
+	{
+		struct Worker
+		{
+			pid_t pid = -1;
+			int to = -1;
+			int from = -1;
+			size_t job = 0;
+			bool busy = false;
+		};
+		Deliveries outcomes(selected.size());
+		deliveries = &outcomes;
+		std::vector<Worker> workers(process_count);
+
+		auto spawn = [&](Worker& worker)
+		{
+			int down[2], up[2];
+			if (::pipe(down) != 0 || ::pipe(up) != 0)
+				throw std::system_error(errno, std::generic_category(), "pipe");
+			std::cout.flush();
+			std::cerr.flush();
+			flush_trace();
+			const auto pid = ::fork();
+			if (pid < 0)
+				throw std::system_error(errno, std::generic_category(), "fork");
+			if (pid == 0)
+			{
+#ifdef __linux__
+				// Don't outlive a parent that exits on a timeout
+				::prctl(PR_SET_PDEATHSIG, SIGKILL);
+#endif
+				for (auto& other : workers) if (other.pid > 0)
+				{
+					::close(other.to);
+					::close(other.from);
+				}
+				::close(down[1]);
+				::close(up[0]);
+				serveCases(down[0], up[1]);
+			}
+			::close(down[0]);
+			::close(up[1]);
+			worker.pid = pid;
+			worker.to = down[1];
+			worker.from = up[0];
+			worker.busy = false;
+		};
+		auto retire = [](Worker& worker)
+		{
+			::close(worker.to);
+			::close(worker.from);
+			int status = 0;
+			while (::waitpid(worker.pid, &status, 0) < 0 && errno == EINTR) { }
+			worker.pid = -1;
+			return status;
+		};
+
+		const auto old_sigpipe = ::signal(SIGPIPE, SIG_IGN);
+		size_t next = 0;
+		auto assign = [&](Worker& worker)
+		{
+			while (next < selected.size())
+			{
+				worker.job = next;
+				const auto index = selected[next];
+				if (write_all(worker.to, &index, sizeof(index)))
+				{
+					next += 1;
+					worker.busy = true;
+					return;
+				}
+				// Worker died between cases, replace it and try again
+				retire(worker);
+				spawn(worker);
+			}
+			retire(worker);
+		};
+
+		for (auto& worker : workers)
+		{
+			spawn(worker);
+			assign(worker);
+		}
+
+		std::vector<pollfd> fds;
+		std::vector<Worker*> polled;
+		for (;;)
+		{
+			fds.clear();
+			polled.clear();
+			for (auto& worker : workers) if (worker.pid > 0 && worker.busy)
+			{
+				fds.push_back({ worker.from, POLLIN, 0 });
+				polled.push_back(&worker);
+			}
+			if (fds.empty())
+				break;
+			if (::poll(fds.data(), fds.size(), -1) < 0)
+			{
+				if (errno == EINTR)
+					continue;
+				throw std::system_error(errno, std::generic_category(), "poll");
+			}
+			for (size_t i = 0; i < fds.size(); ++i) if (fds[i].revents != 0)
+			{
+				auto& worker = *polled[i];
+				Outcome outcome;
+				size_t size = 0;
+				if (read_all(worker.from, &outcome.result, sizeof(outcome.result)) &&
+					read_all(worker.from, &size, sizeof(size)))
+				{
+					outcome.events.resize(size);
+					if (read_all(worker.from, outcome.events.data(), size))
+					{
+						outcomes.finish(worker.job, std::move(outcome));
+						worker.busy = false;
+						assign(worker);
+						continue;
+					}
+				}
+				// The worker died while running the case, record it and carry on with a fresh one
+				const auto status = retire(worker);
+				const auto name = cases()[selected[worker.job]].name;
+				std::ostringstream message;
+				message << '/' << name << '\n';
+				if (WIFSIGNALED(status))
+					message << "worker process killed by signal " << WTERMSIG(status) << " (" << ::strsignal(WTERMSIG(status)) << ")\n";
+				else
+					message << "worker process exited with status " << WEXITSTATUS(status) << "\n";
+				outcome.result = {};
+				outcome.result.subcase_count = 1;
+				outcome.result.exception_count = 1;
+				outcome.events.clear();
+				Recorder recorder(outcome.events);
+				recorder.caseStarted(name);
+				recorder.exceptionThrown({ std::string("/") + name, "", 0, "", message.str(), 1 });
+				recorder.caseDone(name, outcome.result);
+				outcomes.finish(worker.job, std::move(outcome));
+				spawn(worker);
+				assign(worker);
+			}
+			outcomes.deliver(reporter, false);
+		}
+		::signal(SIGPIPE, old_sigpipe);
+		outcomes.deliver(reporter, false);
+		deliveries = nullptr;
+		return outcomes.result;
+	}
+#endif
+
+	static std::vector<size_t> selectCases(const RunOptions& options)
+	{
+		Expects(options.shard_count > 0 && options.shard_index < options.shard_count);
+		std::vector<size_t> selected;
+		size_t matching = 0;
+		for (size_t i = 0; i < cases().size(); ++i)
+		{
+			if (selection && !selection->selects(cases()[i]))
+				continue;
+			if (matching++ % options.shard_count == options.shard_index)
+				selected.push_back(i);
+		}
+		return selected;
+	}
+
+	// Baseline samples by measurement path, one line each: sample count, samples, path
+	// Lines are only appended, so worker processes can record concurrently, and later lines win
+	using PerfBaselines = std::unordered_map<std::string, std::vector<double>>;
+
+	static PerfBaselines load_baselines(const std::string& path, size_t* line_count = nullptr)
+	{
+		PerfBaselines baselines;
+		std::ifstream in(path);
+		std::string line;
+		size_t lines = 0;
+		while (std::getline(in, line))
+		{
+			lines += 1;
+			char* end;
+			const auto count = std::strtoull(line.c_str(), &end, 10);
+			// Each sample takes at least a separator and a digit, a damaged line claiming more is discarded unread
+			if (end == line.c_str() || count > (line.size() - size_t(end - line.c_str())) / 2)
+				continue;
+			std::istringstream fields(end);
+			std::vector<double> samples(count);
+			for (auto& sample : samples)
+				fields >> sample;
+			std::string name;
+			if (!fields || fields.get() != ' ' || !std::getline(fields, name) || name.empty())
+				continue;
+			baselines[name] = std::move(samples);
+		}
+		if (line_count)
+			*line_count = lines;
+		return baselines;
+	}
+	static std::string baseline_line(const std::string& name, const std::vector<double>& samples)
+	{
+		std::ostringstream line;
+		line.precision(9);
+		line << samples.size();
+		for (auto sample : samples)
+			line << ' ' << sample;
+		line << ' ' << name << '\n';
+		return line.str();
+	}
+	// Rewrites the file without superseded lines
+	static void compact_baselines(const std::string& path)
+	{
+		size_t lines = 0;
+		const auto baselines = load_baselines(path, &lines);
+		if (lines == baselines.size())
+			return;
+		const auto temporary = path + ".tmp";
+		{
+			std::ofstream out(temporary);
+			for (auto& [name, samples] : baselines)
+				out << baseline_line(name, samples);
+			if (!out)
+				return;
+		}
+		if (std::rename(temporary.c_str(), path.c_str()) != 0)
+		{
+			std::remove(path.c_str());
+			std::rename(temporary.c_str(), path.c_str());
+		}
+	}
+
+	// The settings of the current run for CHECK_PERF, and the baselines loaded on first use
+	static struct
+	{
+		std::string path;
+		bool record = false;
+		double alpha = 0.01;
+		double tolerance = 0.05;
+
+		std::mutex mutex;
+		std::optional<PerfBaselines> baselines;
+	} perf;
+
+	// Durations and outcomes of cases in earlier runs, one line per case: seconds, 1 if failed, name
+	class TimingDatabase
+	{
+		struct Entry
+		{
+			double seconds = 0;
+			bool failed = false;
+		};
+		std::string _path;
+		std::unordered_map<std::string, Entry> _entries;
+	public:
+		TimingDatabase(std::string path) : _path(std::move(path))
+		{
+			std::ifstream in(_path);
+			double seconds;
+			int failed;
+			std::string name;
+			while (in >> seconds >> failed && in.get() == ' ' && std::getline(in, name))
+				_entries[name] = { seconds, failed != 0 };
+		}
+
+		void record(std::string_view name, const TestResults& results)
+		{
+			_entries[std::string(name)] = { results.timing.wall, results.fail_count + results.exception_count > 0 };
+		}
+
+		// Written to a temporary file first, so an interrupted run leaves the old database intact
+		void save() const
+		{
+			const auto temporary = _path + ".tmp";
+			{
+				std::ofstream out(temporary);
+				out.precision(9);
+				for (auto& [name, entry] : _entries)
+					out << entry.seconds << ' ' << int(entry.failed) << ' ' << name << '\n';
+				if (!out)
+					return;
+			}
+			if (std::rename(temporary.c_str(), _path.c_str()) != 0)
+			{
+				std::remove(_path.c_str());
+				std::rename(temporary.c_str(), _path.c_str());
+			}
+		}
+
+		// Failed cases first, then unknown ones, then the rest, longest first within each group
+		// Starting long cases early keeps a slow one from holding up the end of a parallel run
+		void order(std::vector<size_t>& selected) const
+		{
+			auto key = [&](size_t index)
+			{
+				const auto entry = _entries.find(cases()[index].name);
+				if (entry == _entries.end())
+					return std::make_pair(1, 0.0);
+				return std::make_pair(entry->second.failed ? 0 : 2, -entry->second.seconds);
+			};
+			std::stable_sort(selected.begin(), selected.end(), [&](size_t a, size_t b) { return key(a) < key(b); });
+		}
+	};
+
+	// Passes events on while keeping the totals so far, for reporting a run stopped by a timeout,
+	// and records the cases in the timing database
+	class Tally : public Reporter
+	{
+		Reporter& _reporter;
+		TimingDatabase* _database;
+	public:
+		TestResults results;
+		size_t case_count = 0;
+		// The case started and not yet done, if any
+		std::string_view open;
+
+		Tally(Reporter& reporter, TimingDatabase* database) : _reporter(reporter), _database(database) { }
+
+		// Each event is passed on with reporting held, since a timeout reports from the watchdog thread
+		void caseStarted(std::string_view name) override { std::lock_guard lock(reporting); open = name; _reporter.caseStarted(name); }
+		void assertionFailed(const Failure& failure) override { std::lock_guard lock(reporting); _reporter.assertionFailed(failure); }
+		void exceptionThrown(const Failure& failure) override { std::lock_guard lock(reporting); _reporter.exceptionThrown(failure); }
+		void benchmarkDone(const BenchmarkStats& stats) override { std::lock_guard lock(reporting); _reporter.benchmarkDone(stats); }
+		void fixtureSetUp(std::string_view name, const Timing& timing) override { std::lock_guard lock(reporting); _reporter.fixtureSetUp(name, timing); }
+		void subcaseDone(const SubcaseInfo& info) override { std::lock_guard lock(reporting); _reporter.subcaseDone(info); }
+		void caseDone(std::string_view name, const TestResults& case_results) override
+		{
+			std::lock_guard lock(reporting);
+			open = {};
+			results += case_results;
+			case_count += 1;
+			if (_database)
+				_database->record(name, case_results);
+			_reporter.caseDone(name, case_results);
+		}
+		void runDone(const TestResults& run_results, size_t count, double seconds) override { std::lock_guard lock(reporting); _reporter.runDone(run_results, count, seconds); }
+		void flush() override { std::lock_guard lock(reporting); _reporter.flush(); }
+	};
+
+	TestResults runTests(const RunOptions& options)
 	{
 		using namespace std::chrono;
 		auto then = high_resolution_clock::now();
-		TestResults result;
-		for (auto& test : cases())
-		{
-			report << "case " << test.name << '\n';
-			Expects(subcase_stack().empty());
-			subcase_stack().emplace_back();
-			subcase().name = test.name;
-			subcase().presicion = _presicion;
-			int i = 0;
-			while (!subcase_stack().empty())
-			{
-				result.subcase_count += 1;
-				subcase().reset();
-
-				auto info = runCase(test);
-				if (info.fail_count > 0)
-					report 
-					<< "subcase " << info.id << " done\n"
-					<< info.fail_count << " failures / " << info.assert_count << " assertions\n\n";
-				result.assert_count += info.assert_count;
-				result.fail_count += info.fail_count;
-				result.exception_count += info.exception_count;
-
-				increase_subcase_index();
-				++i;
+
+		std::optional<Selection> filters;
+		if (!options.case_filters.empty() || !options.tag_filters.empty() || !options.subcase_filters.empty())
+			filters.emplace(options);
+		selection = filters ? &*filters : nullptr;
+		load_case_table();
+		auto selected = selectCases(options);
+		if (options.list)
+		{
+			for (auto index : selected)
+			{
+				auto& test = cases()[index];
+				report << test.name;
+				if (*test.tags)
+					report << "  " << test.tags;
+				if (test.file)
+					report << "  " << test.file << '(' << test.line << ')';
+				report << '\n';
 			}
+			selection = nullptr;
+			return {};
+		}
+#ifndef _WIN32
+		fork_subcases = options.fork_subcases;
+#endif
+		perf.path = options.perf_baseline;
+		perf.record = options.perf_record;
+		perf.alpha = options.perf_alpha;
+		perf.tolerance = options.perf_tolerance;
+		perf.baselines.reset();
+		mismatch_limit = options.mismatch_limit;
+		fuzz_corpus = options.fuzz_corpus;
+		start_trace(options.trace);
+		property_trials = options.property_trials;
+		property_seed = options.seed;
+		if (property_seed == 0)
+		{
+			std::random_device device;
+			property_seed = (uint64_t(device()) << 32) | device();
+		}
+		std::optional<TimingDatabase> database;
+		if (!options.timing_database.empty())
+		{
+			database.emplace(options.timing_database);
+			database->order(selected);
+		}
+		auto thread_count = options.threads == 0 ? size_t(std::thread::hardware_concurrency()) : options.threads;
+		thread_count = std::min(thread_count, selected.size());
+		auto process_count = std::min(options.processes, selected.size());
+
+		TextReporter default_reporter(report);
+		default_reporter.slowest = options.slowest;
+		auto& sink = options.reporter ? *options.reporter : default_reporter;
+
+		std::optional<Tally> tally;
+		std::optional<Watchdog> timeouts;
+		case_timeout = options.case_timeout;
+		const bool timed = options.case_timeout > 0 || options.run_timeout > 0 ||
+			std::any_of(selected.begin(), selected.end(), [](size_t i) { return cases()[i].timeout > 0; });
+		if (timed || database)
+			tally.emplace(sink, database ? &*database : nullptr);
+		if (timed)
+		{
+			timeouts.emplace(options.run_timeout, [&](const std::vector<Progress*>& overrun, bool run_expired)
+			{
+				// Kept until the exit below, the cases done come before those over budget
+				reporting.lock();
+				if (deliveries)
+					deliveries->deliverDone(*tally);
+				for (auto p : overrun)
+				{
+					const auto name = p->test->name;
+					TestResults timed_out;
+					timed_out.subcase_count = 1;
+					timed_out.exception_count = 1;
+					if (tally->open != name)
+						tally->caseStarted(name);
+					tally->exceptionThrown(describe_timeout(*p, run_expired));
+					tally->caseDone(name, timed_out);
+				}
+				if (run_expired && overrun.empty())
+				{
+					std::ostringstream message;
+					message << "/\nrun timed out after " << options.run_timeout << "s\n";
+					tally->exceptionThrown({ "/", "", 0, "", message.str(), 1 });
+					tally->results.exception_count += 1;
+				}
+				tally->runDone(tally->results, tally->case_count, duration<double>(high_resolution_clock::now() - then).count());
+				tally->flush();
+				if (database)
+					database->save();
+				if (!options.reporter)
+					std::cout << report.str() << std::flush;
+				std::_Exit(timeout_status);
+			});
+			watchdog = &*timeouts;
 		}
+		auto& reporter = tally ? static_cast<Reporter&>(*tally) : sink;
+
+		expect_fixtures(selected);
+		TestResults result;
+#ifndef _WIN32
+		if (process_count > 0)
+			result = runForked(selected, process_count, reporter);
+		else
+#endif
+		if (thread_count > 1)
+			result = runParallel(selected, thread_count, reporter);
+		else for (auto index : selected)
+			result += runTest(cases()[index], reporter);
+		tear_down_fixtures();
+		report_orphans(reporter, result);
+
+		selection = nullptr;
+#ifndef _WIN32
+		fork_subcases = false;
+#endif
+		watchdog = nullptr;
+		stop_trace();
+		if (database)
+			database->save();
+		if (!perf.path.empty())
+			compact_baselines(perf.path);
 		auto dt = duration<double>(high_resolution_clock::now() - then);
-		report << "tests done in " << dt.count() << "s\n"
-			<< cases().size() << " cases\n" 
-			<< result.subcase_count << " subcases\n"
-			<< result.assert_count << " asserts\n"
-			<< result.fail_count << " failures\n"
-			<< result.exception_count << " uncaught exceptions\n";
+		reporter.runDone(result, selected.size(), dt.count());
 		return result;
 	}
 
+	RunOptions parseArguments(int argc, const char* const argv[])
+	{
+		RunOptions options;
+		std::string_view reporter;
+		std::string_view output;
+		auto count = [](std::string_view flag, const char* value)
+		{
+			char* end = nullptr;
+			const auto result = value ? std::strtoull(value, &end, 10) : 0;
+			if (!value || end == value || *end != '\0')
+				throw std::invalid_argument(std::string(flag) + " expects a number");
+			return size_t(result);
+		};
+		auto seconds = [](std::string_view flag, const char* value)
+		{
+			char* end = nullptr;
+			const auto result = value ? std::strtod(value, &end) : 0;
+			if (!value || end == value || *end != '\0' || result < 0)
+				throw std::invalid_argument(std::string(flag) + " expects seconds");
+			return result;
+		};
+		auto fraction = [](std::string_view flag, const char* value)
+		{
+			char* end = nullptr;
+			const auto result = value ? std::strtod(value, &end) : 0;
+			if (!value || end == value || *end != '\0' || result < 0)
+				throw std::invalid_argument(std::string(flag) + " expects a fraction");
+			return result;
+		};
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string_view arg = argv[i];
+			const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+			if (arg == "--threads")
+				options.threads = count(arg, value), ++i;
+			else if (arg == "--processes")
+				options.processes = count(arg, value), ++i;
+			else if (arg == "--case" && value)
+				options.case_filters.emplace_back(value), ++i;
+			else if (arg == "--tag" && value)
+				options.tag_filters.emplace_back(value), ++i;
+			else if (arg == "--subcase" && value)
+				options.subcase_filters.emplace_back(value), ++i;
+			else if (arg == "--slowest")
+				options.slowest = count(arg, value), ++i;
+			else if (arg == "--timeout")
+				options.case_timeout = seconds(arg, value), ++i;
+			else if (arg == "--run-timeout")
+				options.run_timeout = seconds(arg, value), ++i;
+			else if (arg == "--timing-db" && value)
+				options.timing_database = value, ++i;
+			else if (arg == "--perf-baseline" && value)
+				options.perf_baseline = value, ++i;
+			else if (arg == "--perf-record")
+				options.perf_record = true;
+			else if (arg == "--perf-alpha")
+				options.perf_alpha = fraction(arg, value), ++i;
+			else if (arg == "--perf-tolerance")
+				options.perf_tolerance = fraction(arg, value), ++i;
+			else if (arg == "--list")
+				options.list = true;
+			else if (arg == "--trace" && value)
+				options.trace = value, ++i;
+			else if (arg == "--corpus" && value)
+				options.fuzz_corpus = value, ++i;
+			else if (arg == "--mismatch-limit")
+				options.mismatch_limit = count(arg, value), ++i;
+			else if (arg == "--trials")
+				options.property_trials = count(arg, value), ++i;
+			else if (arg == "--seed")
+				options.seed = count(arg, value), ++i;
+			else if (arg == "--fork-subcases")
+				options.fork_subcases = true;
+			else if (arg == "--reporter")
+				reporter = value ? value : "", ++i;
+			else if (arg == "--output")
+				output = value ? value : "", ++i;
+			else if (arg == "--shard")
+			{
+				const std::string_view shard = value ? value : "";
+				const auto slash = shard.find('/');
+				if (slash == std::string_view::npos)
+					throw std::invalid_argument("--shard expects i/m");
+				options.shard_index = count(arg, std::string(shard.substr(0, slash)).c_str());
+				options.shard_count = count(arg, std::string(shard.substr(slash + 1)).c_str());
+				if (options.shard_count == 0 || options.shard_index >= options.shard_count)
+					throw std::invalid_argument("--shard expects i/m with i < m");
+				++i;
+			}
+		}
+		if (!reporter.empty() || !output.empty())
+		{
+			std::unique_ptr<std::ostream> out;
+			if (!output.empty())
+			{
+				out = std::make_unique<std::ofstream>(std::string(output));
+				if (!*out)
+					throw std::invalid_argument("--output could not open " + std::string(output));
+			}
+			else
+				out = std::make_unique<std::ostream>(std::cout.rdbuf());
+			options.reporter = makeReporter(reporter.empty() ? "text" : reporter, std::move(out));
+			if (auto text = std::dynamic_pointer_cast<TextReporter>(options.reporter))
+				text->slowest = options.slowest;
+		}
+		return options;
+	}
+
 	Subreport::~Subreport()
 	{
 		seekp(0, std::ios::end);
 		auto size = size_t(tellp());
 		if (size != 0)
-			subcase().fails[subcase().assert_count - 1].first_fail = str();
+			subcase().fails[subcase().current_fail].first_fail = str();
 	}
 
 
@@ -314,25 +2746,612 @@ namespace tester
 
 	Case Case::operator<<(Procedure proc) &&
 	{
-		cases().push_back({ _name, std::move(proc) });
+		cases().push_back({ _name, std::move(proc), _tags, _timeout });
 		return *this;
 	}
-	void Subcase::operator<<(const std::function<void()>& procedure) const
+	void Subcase::enter(ProcedureRef procedure)
 	{
-		if (_shall_enter)
-			perform(procedure);
+		perform(procedure);
+	}
+
+	// Runs the iterations of a Repeat on several threads, each with a copy of the subcase path
+	// Failures are merged into the repeat level as if the iterations had run in order
+	static void repeat_parallel(ProcedureRef procedure, size_t count, size_t threads)
+	{
+		using SubcaseData = std::decay_t<decltype(subcase_stack().front())>;
+		using AssertData = decltype(SubcaseData::fails)::value_type;
+		const auto depth = subcase_depth();
+		const auto& stack = subcase_stack();
+		std::vector<SubcaseData> path(depth + 1);
+		for (size_t i = 0; i <= depth; ++i)
+		{
+			path[i].node = stack[i].node;
+			path[i].section = stack[i].section;
+			path[i].iteration = stack[i].iteration;
+			path[i].presicion = stack[i].presicion;
+		}
+		const auto p = stack[depth - 1].presicion;
+		path[depth].section.clear();
+
+		if (threads == 0)
+			threads = std::max(1u, std::thread::hardware_concurrency());
+		threads = std::min(threads, count);
+		// Iterations are handed out in chunks, so workers rarely contend on the counter
+		const size_t chunk = std::clamp<size_t>(count / (threads * 16), 1, 4096);
+		std::atomic<size_t> next = 0;
+		std::vector<SubcaseData> results(threads);
+		size_t last_assert_count = 0;
+		std::vector<std::thread> workers;
+		for (size_t w = 0; w < threads; ++w)
+			workers.emplace_back([&, w, tree = &subcase_tree(), trace_path = trace_path_ids, inbox = case_inbox]
+			{
+				borrowed_tree = tree;
+				trace_path_ids = trace_path;
+				// Fixtures used by the body are held by the case, and released when it is done
+				case_inbox = inbox;
+				auto& local = subcase_stack();
+				local = path;
+				subcase_depth() = depth;
+				for (;;)
+				{
+					const auto begin = next.fetch_add(chunk);
+					if (begin >= count)
+						break;
+					for (auto i = begin; i < std::min(begin + chunk, count); ++i)
+					{
+						auto& subc = subcase();
+						subc.reset();
+						subc.iteration = i;
+						subc.presicion = p;
+						perform(procedure);
+						if (i == count - 1)
+							last_assert_count = subcase().assert_count;
+					}
+				}
+				results[w] = std::move(local[depth]);
+				local.clear();
+				subcase_depth() = 0;
+				case_inbox = nullptr;
+				borrowed_tree = nullptr;
+			});
+		for (auto& worker : workers)
+			worker.join();
+
+		// Merged in order of the first failing iteration, keeping the report of that iteration
+		std::vector<const AssertData*> order;
+		for (auto& result : results)
+			for (auto& fail : result.fails)
+				order.push_back(&fail);
+		std::stable_sort(order.begin(), order.end(), [](auto a, auto b) { return a->iteration < b->iteration; });
+
+		auto& level = subcase();
+		for (auto fail : order)
+		{
+			auto [site, inserted] = level.fail_sites.try_emplace({ fail->file, fail->line, fail->expr }, level.fails.size());
+			if (inserted)
+				level.fails.push_back(*fail);
+			else
+				level.fails[site->second].fail_count += fail->fail_count;
+		}
+		for (auto& result : results)
+		{
+			auto& exception = level.exception;
+			const auto total = exception.fail_count + result.exception.fail_count;
+			if (result.exception.fail_count > 0 && (exception.fail_count == 0 || result.exception.iteration < exception.iteration))
+				exception = std::move(result.exception);
+			exception.fail_count = total;
+			for (auto& stats : result.benchmarks)
+				level.benchmarks.push_back(std::move(stats));
+			for (auto& fixture : result.fixtures)
+				level.fixtures.push_back(fixture);
+		}
+		// Like the serial loop, the level ends with the assertion count of the last iteration
+		level.assert_count = last_assert_count;
+		level.iteration = count - 1;
 	}
 
-	void Repeat::operator<<(const std::function<void()>& procedure) const
+	void Repeat::run(ProcedureRef procedure) const
 	{
-		Subcase("repeat(" + std::to_string(_count) + ")") << [&]
+		// Formatted on the stack, the subcase name reuses its storage from the previous run
+		char name[32] = "repeat(";
+		auto end = std::to_chars(name + 7, name + sizeof(name) - 1, _count).ptr;
+		*end++ = ')';
+		Subcase({ name, size_t(end - name) }) << [&]
 		{
+			if (_threads != 1 && _count > 1)
+				return repeat_parallel(procedure, _count, _threads);
+			// Nested subcases can grow the stack, so the level is looked up again each iteration
+			const auto p = subcase_stack()[subcase_depth() - 1].presicion;
+			subcase().section.clear();
 			for (size_t i = 0; i < _count; ++i)
 			{
-				subcase().reset();
-				section = std::to_string(i);
+				auto& subc = subcase();
+				subc.reset();
+				subc.iteration = i;
+				subc.presicion = p;
 				perform(procedure);
 			}
 		};
 	}
+
+	namespace slim
+	{
+		static std::ostream& operator<<(std::ostream& out, const Value& value)
+		{
+			switch (value.kind)
+			{
+			case Value::Kind::Bool: return out << bool(value.i);
+			case Value::Kind::Char: return out << char(value.i);
+			case Value::Kind::Signed: return out << value.i;
+			case Value::Kind::Unsigned: return out << value.u;
+			case Value::Kind::Float: return out << value.f;
+			case Value::Kind::Pointer: return out << value.p;
+			case Value::Kind::String: return out << value.s;
+			default: return out << '{' << value.s << '}';
+			}
+		}
+		static tester::Assertion full(const Assertion& info) { return { info.file, info.line, info.expr }; }
+
+		void increaseCount(const Assertion& info)
+		{
+			full(info).increaseCount();
+		}
+		void fail(const Assertion& info, const Value& value)
+		{
+			if (report_failure(full(info)))
+				Subreport{} <<
+				full(info) << "failed: expands to\n" <<
+				"    " << value << "\n";
+		}
+		void fail(const Assertion& info, const Value& a, Op op, const Value& b)
+		{
+			if (report_failure(full(info)))
+				Subreport{} <<
+				full(info) << "failed: expands to\n" <<
+				"    " << a << tester::Op(op) << b << "\n";
+		}
+		void check_approx(const Assertion& info, double a, Op op, double b)
+		{
+			if (op == Op::NE)
+				tester::check_approx(full(info), tester::split << a != b);
+			else
+				tester::check_approx(full(info), tester::split << a == b);
+		}
+		void check_noexcept(const Assertion& info, ProcedureRef test)
+		{
+			tester::check_noexcept(full(info), test);
+		}
+
+		Case Case::operator<<(void (*proc)()) &&
+		{
+			tester::Case(_name, _tags, _timeout) << proc;
+			return *this;
+		}
+		Subcase::Subcase(std::string_view name) : _shall_enter(begin_subcase(name)) { }
+		Subcase::~Subcase() { end_subcase(_shall_enter); }
+		void Subcase::enter(ProcedureRef procedure)
+		{
+			perform(procedure);
+		}
+		void Repeat::run(ProcedureRef procedure) const
+		{
+			tester::Repeat(_count) << procedure;
+		}
+	}
+
+	static std::ostream& print_duration(std::ostream& out, double seconds)
+	{
+		if (seconds < 1e-6)
+			return out << seconds * 1e9 << "ns";
+		if (seconds < 1e-3)
+			return out << seconds * 1e6 << "us";
+		if (seconds < 1)
+			return out << seconds * 1e3 << "ms";
+		return out << seconds << "s";
+	}
+
+	std::ostream& operator<<(std::ostream& out, const Timing& timing)
+	{
+		out << "wall ";
+		print_duration(out, timing.wall) << "  cpu ";
+		print_duration(out, timing.cpu);
+		if (timing.counters)
+			out << "  cycles " << timing.cycles 
+				<< "  instructions " << timing.instructions
+				<< "  cache misses " << timing.cache_misses
+				<< "  branch misses " << timing.branch_misses;
+		return out;
+	}
+
+	std::ostream& operator<<(std::ostream& out, const BenchmarkStats& stats)
+	{
+		out << "benchmark " << stats.name << '\n'
+			<< "    " << stats.samples << " samples of " << stats.iterations << " iterations\n"
+			<< "    min ";
+		print_duration(out, stats.min) << "  median ";
+		print_duration(out, stats.median) << "  mean ";
+		print_duration(out, stats.mean) << "  mad ";
+		print_duration(out, stats.mad) << "  stddev ";
+		print_duration(out, stats.stddev) << "\n";
+		if (stats.max > 0)
+		{
+			out << "    p90 ";
+			print_duration(out, stats.p90) << "  p99 ";
+			print_duration(out, stats.p99) << "  p99.9 ";
+			print_duration(out, stats.p999) << "  max ";
+			print_duration(out, stats.max) << "\n";
+		}
+		return out << "\n";
+	}
+
+	// Seconds per iteration of each sample, with the iteration count calibrated so a sample takes at least sample_time
+	static std::vector<double> measure(const std::function<void(size_t)>& batch, size_t sample_count, double sample_time, size_t& iterations)
+	{
+		using clock = std::chrono::steady_clock;
+		auto time = [&](size_t iterations)
+		{
+			const auto then = clock::now();
+			batch(iterations);
+			return std::chrono::duration<double>(clock::now() - then).count();
+		};
+
+		// Warm up, then grow the batch until one sample is long enough to time reliably
+		time(1);
+		iterations = 1;
+		for (auto elapsed = time(iterations); elapsed < sample_time; elapsed = time(iterations))
+		{
+			const auto estimate = elapsed > 0 ? sample_time / elapsed * 1.2 : 10.0;
+			iterations = size_t(double(iterations) * std::clamp(estimate, 2.0, 10.0));
+		}
+
+		std::vector<double> samples(std::max<size_t>(sample_count, 1));
+		for (auto& sample : samples)
+			sample = time(iterations) / double(iterations);
+		return samples;
+	}
+
+	static double median(std::vector<double> values)
+	{
+		const auto mid = values.size() / 2;
+		std::nth_element(values.begin(), values.begin() + mid, values.end());
+		if (values.size() % 2 != 0)
+			return values[mid];
+		return (values[mid] + *std::max_element(values.begin(), values.begin() + mid)) / 2;
+	}
+
+	static BenchmarkStats summarize(std::string_view suffix, size_t iterations, const std::vector<double>& samples)
+	{
+		BenchmarkStats stats;
+		std::ostringstream name;
+		print_stack(name);
+		if (!suffix.empty())
+			name << '/' << suffix;
+		stats.name = name.str();
+		stats.iterations = iterations;
+		stats.samples = samples.size();
+
+		stats.min = *std::min_element(samples.begin(), samples.end());
+		stats.median = median(samples);
+		double sum = 0;
+		for (auto sample : samples)
+			sum += sample;
+		stats.mean = sum / double(samples.size());
+		double square_sum = 0;
+		std::vector<double> deviations;
+		for (auto sample : samples)
+		{
+			square_sum += (sample - stats.mean) * (sample - stats.mean);
+			deviations.push_back(std::abs(sample - stats.median));
+		}
+		stats.stddev = samples.size() > 1 ? std::sqrt(square_sum / double(samples.size() - 1)) : 0;
+		stats.mad = median(std::move(deviations));
+		return stats;
+	}
+
+	void Benchmark::run(const std::function<void(size_t)>& batch) const
+	{
+		size_t iterations;
+		const auto samples = measure(batch, _samples, _sample_time, iterations);
+		subcase().benchmarks.push_back(summarize(_name, iterations, samples));
+	}
+
+	double LatencyHistogram::stddev() const
+	{
+		if (_count < 2)
+			return 0;
+		const double mean = _sum / double(_count);
+		return std::sqrt(std::max(0.0, (_sum_squares - mean * _sum) / double(_count - 1))) * 1e-9;
+	}
+	double LatencyHistogram::percentile(double percent) const
+	{
+		if (_count == 0)
+			return 0;
+		const auto rank = std::max<uint64_t>(1, uint64_t(std::ceil(std::clamp(percent, 0.0, 100.0) / 100 * double(_count))));
+		uint64_t seen = 0;
+		for (size_t i = 0; i < _counts.size(); ++i)
+		{
+			seen += _counts[i];
+			if (seen >= rank)
+				return double(std::min(highest(i), _max)) * 1e-9;
+		}
+		return max();
+	}
+
+	double LatencyHistogram::mad() const
+	{
+		if (_count < 2)
+			return 0;
+		// Values are taken as spread evenly over their bucket, otherwise the deviation within the bucket
+		// of the median, often holding half of the values, would be lost
+		const double median = percentile(50) * 1e9;
+		auto within = [&](double deviation)
+		{
+			double count = 0;
+			for (size_t i = 0; i < _counts.size(); ++i)
+			{
+				if (_counts[i] == 0)
+					continue;
+				const double low = i == 0 ? 0 : double(highest(i - 1) + 1);
+				const double high = double(highest(i) + 1);
+				const double overlap = std::min(high, median + deviation) - std::max(low, median - deviation);
+				if (overlap > 0)
+					count += double(_counts[i]) * overlap / (high - low);
+			}
+			return count;
+		};
+		double low = 0, high = double(_max) + median;
+		for (int i = 0; i < 64 && high - low > 1e-3; ++i)
+		{
+			const double middle = (low + high) / 2;
+			if (within(middle) < double(_count) / 2)
+				low = middle;
+			else
+				high = middle;
+		}
+		return high * 1e-9;
+	}
+
+	void Latency::run(ProcedureRef procedure)
+	{
+		// Named before the Repeat adds its level
+		std::ostringstream name;
+		print_stack(name);
+		if (!_name.empty())
+			name << '/' << _name;
+
+		using clock = std::chrono::steady_clock;
+		Repeat(_count) << [&]
+		{
+			const auto then = clock::now();
+			procedure();
+			_histogram.record(uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - then).count()));
+		};
+		if (_histogram.count() == 0)
+			return;
+
+		BenchmarkStats stats;
+		stats.name = name.str();
+		stats.iterations = 1;
+		stats.samples = size_t(_histogram.count());
+		stats.min = _histogram.min();
+		stats.median = _histogram.percentile(50);
+		stats.mean = _histogram.mean();
+		stats.mad = _histogram.mad();
+		stats.stddev = _histogram.stddev();
+		stats.p90 = _histogram.percentile(90);
+		stats.p99 = _histogram.percentile(99);
+		stats.p999 = _histogram.percentile(99.9);
+		stats.max = _histogram.max();
+		subcase().benchmarks.push_back(std::move(stats));
+	}
+
+	void check_percentile_below(const Assertion& info, const Latency& latency, double percent, double limit)
+	{
+		const auto& histogram = latency.histogram();
+		if (histogram.count() == 0)
+			return;
+		info.increaseCount();
+		const auto value = histogram.percentile(percent);
+		if (value < limit || !report_failure(info))
+			return;
+		Subreport subreport;
+		subreport << info << "failed: p" << percent << " is ";
+		print_duration(subreport, value) << ", limit ";
+		print_duration(subreport, limit) << "\n    " << histogram.count() << " samples  p50 ";
+		print_duration(subreport, histogram.percentile(50)) << "  p90 ";
+		print_duration(subreport, histogram.percentile(90)) << "  p99 ";
+		print_duration(subreport, histogram.percentile(99)) << "  p99.9 ";
+		print_duration(subreport, histogram.percentile(99.9)) << "  max ";
+		print_duration(subreport, histogram.max()) << "\n";
+	}
+
+	// Probability of a U at least as large as that of current, if current were not slower than baseline
+	// Normal approximation with tie correction, good from about 10 samples each
+	static double mann_whitney_p(const std::vector<double>& baseline, const std::vector<double>& current)
+	{
+		std::vector<std::pair<double, bool>> all;
+		for (auto x : baseline)
+			all.emplace_back(x, false);
+		for (auto x : current)
+			all.emplace_back(x, true);
+		std::sort(all.begin(), all.end());
+
+		const double n1 = double(baseline.size());
+		const double n2 = double(current.size());
+		const double n = n1 + n2;
+		double rank_sum = 0;
+		double ties = 0;
+		for (size_t i = 0; i < all.size(); )
+		{
+			auto j = i;
+			while (j < all.size() && all[j].first == all[i].first)
+				++j;
+			const double rank = double(i + j + 1) / 2;
+			const double t = double(j - i);
+			ties += t * t * t - t;
+			for (auto k = i; k < j; ++k)
+				if (all[k].second)
+					rank_sum += rank;
+			i = j;
+		}
+		const double u = rank_sum - n2 * (n2 + 1) / 2;
+		const double sigma = std::sqrt(n1 * n2 / 12 * ((n + 1) - ties / (n * (n - 1))));
+		if (sigma == 0)
+			return u > n1 * n2 / 2 ? 0 : 1;
+		const double z = (u - n1 * n2 / 2 - 0.5) / sigma;
+		return 0.5 * std::erfc(z / std::sqrt(2.0));
+	}
+
+	static std::ostream& print_distribution(std::ostream& out, std::vector<double> samples)
+	{
+		std::sort(samples.begin(), samples.end());
+		auto at = [&](double q) { return samples[size_t(q * double(samples.size() - 1) + 0.5)]; };
+		out << samples.size() << " samples  min ";
+		print_duration(out, at(0)) << "  q1 ";
+		print_duration(out, at(0.25)) << "  median ";
+		print_duration(out, at(0.5)) << "  q3 ";
+		print_duration(out, at(0.75)) << "  max ";
+		return print_duration(out, at(1));
+	}
+
+	void details::check_perf(const Assertion& info, const std::function<void(size_t)>& batch, size_t sample_count, double sample_time)
+	{
+		size_t iterations;
+		const auto samples = measure(batch, sample_count, sample_time, iterations);
+		auto stats = summarize(info.expr, iterations, samples);
+		const auto name = stats.name;
+		subcase().benchmarks.push_back(std::move(stats));
+
+		std::vector<double> baseline;
+		{
+			std::lock_guard lock(perf.mutex);
+			if (perf.path.empty())
+				return;
+			if (!perf.baselines)
+				perf.baselines = load_baselines(perf.path);
+			auto found = perf.baselines->find(name);
+			if (found == perf.baselines->end() || perf.record)
+			{
+				std::ofstream(perf.path, std::ios::app) << baseline_line(name, samples);
+				(*perf.baselines)[name] = samples;
+				return;
+			}
+			baseline = found->second;
+		}
+
+		const auto p = mann_whitney_p(baseline, samples);
+		const auto change = median(samples) / median(baseline) - 1;
+		if (p >= perf.alpha || change <= perf.tolerance || !report_failure(info))
+			return;
+		Subreport subreport;
+		subreport << info << "failed: slower than baseline, median " << (change >= 0 ? "+" : "") << change * 100 << "%, p = " << p << "\n";
+		print_distribution(subreport << "    baseline: ", baseline) << "\n";
+		print_distribution(subreport << "    current:  ", samples) << "\n";
+	}
+
+	BenchmarkCase BenchmarkCase::operator<<(Procedure proc) &&
+	{
+		cases().push_back({ _name, [proc = std::move(proc)]{ Benchmark("") << proc; }, _tags, _timeout });
+		return *this;
+	}
+
+	struct FuzzData
+	{
+		const char* name;
+		void (*body)(Bytes);
+	};
+	static auto& fuzz_cases()
+	{
+		static std::vector<FuzzData> data;
+		return data;
+	}
+
+	// Runs the body over the corpus of the case, one section per file
+	static void replay_corpus(const FuzzData& fuzz)
+	{
+		std::vector<std::filesystem::path> files;
+		std::error_code error;
+		const auto directory = std::filesystem::path(fuzz_corpus) / fuzz.name;
+		if (!fuzz_corpus.empty() && std::filesystem::is_directory(directory, error))
+			for (auto& entry : std::filesystem::directory_iterator(directory, error))
+				if (entry.is_regular_file(error))
+					files.push_back(entry.path());
+		if (files.empty())
+			return fuzz.body({});
+		std::sort(files.begin(), files.end());
+
+		Subcase("corpus") << [&]
+		{
+			std::vector<unsigned char> input;
+			for (auto& file : files)
+			{
+				auto& subc = subcase();
+				subc.reset();
+				subc.section = file.filename().string();
+				std::ifstream in(file, std::ios::binary);
+				input.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+				perform([&] { fuzz.body({ input.data(), input.size() }); });
+			}
+		};
+	}
+
+	FuzzCase FuzzCase::operator<<(void (*body)(Bytes)) &&
+	{
+		fuzz_cases().push_back({ _name, body });
+		const FuzzData fuzz = fuzz_cases().back();
+		cases().push_back({ _name, [fuzz] { replay_corpus(fuzz); }, _tags, _timeout });
+		return *this;
+	}
+
+	int fuzzOne(const char* name, const unsigned char* data, size_t size)
+	{
+		// Found once, fuzzers call this for the same case with every input
+		thread_local const FuzzData* fuzz = nullptr;
+		thread_local const char* requested = nullptr;
+		if (!fuzz || name != requested)
+		{
+			requested = name;
+			auto& all = fuzz_cases();
+			auto found = std::find_if(all.begin(), all.end(), [&](auto& f) { return name ? std::strcmp(f.name, name) == 0 : all.size() == 1; });
+			if (found == all.end())
+			{
+				std::fprintf(stderr, "no fuzz case %s\n", name ? name : "given, and more than one is registered");
+				std::abort();
+			}
+			fuzz = &*found;
+		}
+
+		// Every input starts the case over and runs each of its subcases, as runTest does
+		auto& stack = subcase_stack();
+		stack.clear();
+		stack.emplace_back();
+		stack.back().node = subcase_tree().reset(fuzz->name);
+		stack.back().presicion = _presicion;
+		subcase_depth() = 0;
+		while (!stack.empty())
+		{
+			subcase().reset();
+			fuzz->body({ data, size });
+			bool failed = false;
+			for (auto& level : stack)
+			{
+				for (auto& fail : level.fails)
+				{
+					failed = true;
+					if (!fail.first_fail.empty())
+						std::fputs(fail.first_fail.c_str(), stderr);
+					else
+						std::fprintf(stderr, "%s\n%s(%u)\n    %s\nfailed\n", fail.path.c_str(), fail.file, fail.line, fail.expr);
+				}
+				level.assert_count = 0;
+			}
+			if (failed)
+			{
+				std::fflush(stderr);
+				std::abort();
+			}
+			increase_subcase_index();
+		}
+		return 0;
+	}
 }
@@ -0,0 +1,88 @@
+// Optional: link this file into a test binary to count allocations per thread
+// It replaces the global operator new and delete, see tester::AllocationCounters
+#include "tester.h"
+
+#include <cstdlib>
+#include <cstddef>
+#include <new>
+
+namespace
+{
+	// Every block starts with a header holding the requested size, so live bytes can be tracked on delete
+	constexpr size_t header_size(size_t align)
+	{
+		return align > alignof(std::max_align_t) ? align : alignof(std::max_align_t);
+	}
+
+	void* allocate(size_t size, size_t align) noexcept
+	{
+		const auto header = header_size(align);
+		void* block;
+		if (align > alignof(std::max_align_t))
+#ifdef _WIN32
+			block = ::_aligned_malloc(size + header, align);
+#else
+			block = std::aligned_alloc(align, (size + header + align - 1) / align * align);
+#endif
+		else
+			block = std::malloc(size + header);
+		if (!block)
+			return nullptr;
+		*static_cast<size_t*>(block) = size;
+
+		auto& counters = tester::details::allocation_counters();
+		const auto recorded = counters.allocations - counters.record_base;
+		if (recorded < std::size(counters.sizes))
+			counters.sizes[recorded] = size;
+		counters.allocations += 1;
+		counters.bytes += size;
+		counters.live += ptrdiff_t(size);
+		if (counters.live > counters.peak)
+			counters.peak = counters.live;
+		return static_cast<char*>(block) + header;
+	}
+
+	void deallocate(void* p, size_t align) noexcept
+	{
+		if (!p)
+			return;
+		const auto block = static_cast<char*>(p) - header_size(align);
+		auto& counters = tester::details::allocation_counters();
+		counters.deallocations += 1;
+		counters.live -= ptrdiff_t(*reinterpret_cast<size_t*>(block));
+#ifdef _WIN32
+		if (align > alignof(std::max_align_t))
+			return ::_aligned_free(block);
+#endif
+		std::free(block);
+	}
+
+	void* allocate_or_throw(size_t size, size_t align)
+	{
+		if (auto p = allocate(size, align))
+			return p;
+		throw std::bad_alloc();
+	}
+}
+
+void* operator new  (size_t size) { return allocate_or_throw(size, 0); }
+void* operator new[](size_t size) { return allocate_or_throw(size, 0); }
+void* operator new  (size_t size, std::align_val_t align) { return allocate_or_throw(size, size_t(align)); }
+void* operator new[](size_t size, std::align_val_t align) { return allocate_or_throw(size, size_t(align)); }
+void* operator new  (size_t size, const std::nothrow_t&) noexcept { return allocate(size, 0); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return allocate(size, 0); }
+void* operator new  (size_t size, std::align_val_t align, const std::nothrow_t&) noexcept { return allocate(size, size_t(align)); }
+void* operator new[](size_t size, std::align_val_t align, const std::nothrow_t&) noexcept { return allocate(size, size_t(align)); }
+
+void operator delete  (void* p) noexcept { deallocate(p, 0); }
+void operator delete[](void* p) noexcept { deallocate(p, 0); }
+void operator delete  (void* p, size_t) noexcept { deallocate(p, 0); }
+void operator delete[](void* p, size_t) noexcept { deallocate(p, 0); }
+void operator delete  (void* p, std::align_val_t align) noexcept { deallocate(p, size_t(align)); }
+void operator delete[](void* p, std::align_val_t align) noexcept { deallocate(p, size_t(align)); }
+void operator delete  (void* p, size_t, std::align_val_t align) noexcept { deallocate(p, size_t(align)); }
+void operator delete[](void* p, size_t, std::align_val_t align) noexcept { deallocate(p, size_t(align)); }
+void operator delete  (void* p, const std::nothrow_t&) noexcept { deallocate(p, 0); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { deallocate(p, 0); }
+void operator delete  (void* p, std::align_val_t align, const std::nothrow_t&) noexcept { deallocate(p, size_t(align)); }
+void operator delete[](void* p, std::align_val_t align, const std::nothrow_t&) noexcept { deallocate(p, size_t(align)); }
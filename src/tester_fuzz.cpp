@@ -0,0 +1,13 @@
+// Optional: link this file into a libFuzzer build (-fsanitize=fuzzer) to fuzz a tester::FuzzCase
+// The case is named by the TESTER_FUZZ_CASE environment variable, which can be left unset when there is only one
+#include "tester.h"
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstddef>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+	static const char* name = std::getenv("TESTER_FUZZ_CASE");
+	return tester::fuzzOne(name, data, size);
+}
@@ -0,0 +1,327 @@
+#include "tester_reporters.h"
+
+#include <stdexcept>
+#include <system_error>
+#include <cerrno>
+#include <cstdio>
+#include <algorithm>
+#include <cmath>
+
+namespace tester
+{
+	void TextReporter::caseStarted(std::string_view name)
+	{
+		out << "case " << name << '\n';
+	}
+	void TextReporter::assertionFailed(const Failure& failure)
+	{
+		out << failure.message;
+		if (failure.count > 1)
+			out << "  (first failure, failed " << failure.count << " times)\n";
+		out << "\n";
+	}
+	void TextReporter::exceptionThrown(const Failure& failure)
+	{
+		out << failure.message;
+		if (failure.count > 1)
+			out << "  (first exception, " << failure.count << " exceptions thrown)\n";
+		out << "\n";
+	}
+	void TextReporter::benchmarkDone(const BenchmarkStats& stats)
+	{
+		out << stats;
+	}
+	void TextReporter::fixtureSetUp(std::string_view name, const Timing& timing)
+	{
+		out << "fixture " << name << " set up\n        " << timing << '\n';
+	}
+	void TextReporter::subcaseDone(const SubcaseInfo& info)
+	{
+		if (info.fail_count > 0)
+			out
+			<< "subcase " << info.id << " done\n"
+			<< info.fail_count << " failures / " << info.assert_count << " assertions\n\n";
+		keepSlowest(_slowest_subcases, info.id, info.timing);
+	}
+	void TextReporter::caseDone(std::string_view name, const TestResults& results)
+	{
+		keepSlowest(_slowest_cases, name, results.timing);
+		out.flush();
+	}
+	void TextReporter::keepSlowest(std::vector<Timed>& list, std::string_view name, const Timing& timing)
+	{
+		if (slowest == 0)
+			return;
+		list.push_back({ std::string(name), timing });
+		if (list.size() >= 2 * slowest)
+		{
+			auto by_wall = [](const Timed& a, const Timed& b) { return a.timing.wall > b.timing.wall; };
+			std::nth_element(list.begin(), list.begin() + slowest, list.end(), by_wall);
+			list.resize(slowest);
+		}
+	}
+	void TextReporter::printSlowest(std::string_view title, std::vector<Timed>& list)
+	{
+		if (list.empty())
+			return;
+		std::sort(list.begin(), list.end(), [](const Timed& a, const Timed& b) { return a.timing.wall > b.timing.wall; });
+		if (list.size() > slowest)
+			list.resize(slowest);
+		out << "slowest " << title << ":\n";
+		for (auto& timed : list)
+			out << "    " << timed.name << "\n        " << timed.timing << '\n';
+		list.clear();
+	}
+	void TextReporter::runDone(const TestResults& results, size_t case_count, double seconds)
+	{
+		out << "tests done in " << seconds << "s\n"
+			<< case_count << " cases\n"
+			<< results.subcase_count << " subcases\n"
+			<< results.assert_count << " asserts\n"
+			<< results.fail_count << " failures\n"
+			<< results.exception_count << " uncaught exceptions\n";
+		if (results.benchmark_count > 0)
+			out << results.benchmark_count << " benchmarks\n";
+		if (results.allocations.allocations > 0)
+			out << results.allocations.allocations << " allocations of " << results.allocations.bytes << " bytes, "
+				<< "peak " << results.allocations.peak << " bytes live\n";
+		printSlowest("cases", _slowest_cases);
+		printSlowest("subcases", _slowest_subcases);
+		out.flush();
+	}
+
+
+	namespace
+	{
+		struct Xml { std::string_view text; };
+		std::ostream& operator<<(std::ostream& out, Xml xml)
+		{
+			for (auto c : xml.text) switch (c)
+			{
+			case '<': out << "&lt;"; break;
+			case '>': out << "&gt;"; break;
+			case '&': out << "&amp;"; break;
+			case '"': out << "&quot;"; break;
+			case '\'': out << "&apos;"; break;
+			default: out << c;
+			}
+			return out;
+		}
+
+		struct Json { std::string_view text; };
+		std::ostream& operator<<(std::ostream& out, Json json)
+		{
+			static constexpr char hex[] = "0123456789abcdef";
+			out << '"';
+			for (auto c : json.text) switch (c)
+			{
+			case '"': out << "\\\""; break;
+			case '\\': out << "\\\\"; break;
+			case '\n': out << "\\n"; break;
+			case '\r': out << "\\r"; break;
+			case '\t': out << "\\t"; break;
+			default:
+				if (static_cast<unsigned char>(c) < 0x20)
+					out << "\\u00" << hex[(c >> 4) & 0xf] << hex[c & 0xf];
+				else
+					out << c;
+			}
+			return out << '"';
+		}
+
+
+		// JSON has no nan or infinity, so those are written as null
+		struct JsonNumber { double value; };
+		std::ostream& operator<<(std::ostream& out, JsonNumber json)
+		{
+			if (std::isfinite(json.value))
+				return out << json.value;
+			return out << "null";
+		}
+
+		struct JsonTiming { const Timing& timing; };
+		std::ostream& operator<<(std::ostream& out, JsonTiming json)
+		{
+			out << ",\"wall\":" << JsonNumber{ json.timing.wall } << ",\"cpu\":" << JsonNumber{ json.timing.cpu };
+			if (json.timing.counters)
+				out << ",\"cycles\":" << json.timing.cycles
+					<< ",\"instructions\":" << json.timing.instructions
+					<< ",\"cache_misses\":" << json.timing.cache_misses
+					<< ",\"branch_misses\":" << json.timing.branch_misses;
+			return out;
+		}
+
+		struct JsonAllocations { const AllocationStats& allocations; };
+		std::ostream& operator<<(std::ostream& out, JsonAllocations json)
+		{
+			return out 
+				<< ",\"allocations\":" << json.allocations.allocations
+				<< ",\"allocated_bytes\":" << json.allocations.bytes
+				<< ",\"peak_bytes\":" << json.allocations.peak;
+		}
+	}
+
+	void JUnitReporter::caseStarted(std::string_view)
+	{
+		_case.str("");
+	}
+	void JUnitReporter::assertionFailed(const Failure& failure)
+	{
+		_case << "<failure type=\"assertion\" message=\"" 
+			<< Xml{ failure.file } << '(' << failure.line << "): " << Xml{ failure.expr } << "\">"
+			<< Xml{ failure.message };
+		if (failure.count > 1)
+			_case << "(failed " << failure.count << " times)\n";
+		_case << "</failure>\n";
+	}
+	void JUnitReporter::exceptionThrown(const Failure& failure)
+	{
+		_case << "<error type=\"exception\" message=\"uncaught exception in " << Xml{ failure.path } << "\">"
+			<< Xml{ failure.message };
+		if (failure.count > 1)
+			_case << "(" << failure.count << " exceptions thrown)\n";
+		_case << "</error>\n";
+	}
+	void JUnitReporter::benchmarkDone(const BenchmarkStats& stats)
+	{
+		std::ostringstream text;
+		text << stats;
+		_case << "<system-out>" << Xml{ text.str() } << "</system-out>\n";
+	}
+	JUnitReporter::~JUnitReporter()
+	{
+		if (_spool)
+			std::fclose(_spool);
+	}
+	void JUnitReporter::writeCase(std::string_view name, double seconds)
+	{
+		if (!_spool && !(_spool = std::tmpfile()))
+			throw std::system_error(errno, std::generic_category(), "tmpfile");
+		std::ostringstream element;
+		element << "<testcase classname=\"tester\" name=\"" << Xml{ name } << "\" time=\"" << seconds << "\">\n"
+			<< _case.str()
+			<< "</testcase>\n";
+		const auto text = element.str();
+		std::fwrite(text.data(), 1, text.size(), _spool);
+		std::fflush(_spool);
+		_case.str("");
+		_tests += 1;
+	}
+	void JUnitReporter::caseDone(std::string_view name, const TestResults& results)
+	{
+		if (results.fail_count > 0)
+			_failures += 1;
+		else if (results.exception_count > 0)
+			_errors += 1;
+		writeCase(name, results.timing.wall);
+	}
+	void JUnitReporter::runDone(const TestResults&, size_t, double seconds)
+	{
+		// Failures of threads outside any case come last, as a case of their own
+		if (_case.tellp() > 0)
+		{
+			_failures += 1;
+			writeCase("(outside any case)", 0);
+		}
+		out << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+			<< "<testsuites tests=\"" << _tests << "\" failures=\"" << _failures << "\" errors=\"" << _errors << "\" time=\"" << seconds << "\">\n"
+			<< "<testsuite name=\"tester\" tests=\"" << _tests << "\" failures=\"" << _failures << "\" errors=\"" << _errors << "\" time=\"" << seconds << "\">\n";
+		if (_spool)
+		{
+			std::rewind(_spool);
+			char buffer[1 << 16];
+			while (const auto n = std::fread(buffer, 1, sizeof(buffer), _spool))
+				out.write(buffer, std::streamsize(n));
+			std::fclose(_spool);
+			_spool = nullptr;
+		}
+		out << "</testsuite>\n"
+			<< "</testsuites>\n";
+		out.flush();
+	}
+
+
+	void JsonLinesReporter::caseStarted(std::string_view name)
+	{
+		out << "{\"event\":\"case_started\",\"name\":" << Json{ name } << "}\n";
+	}
+	void JsonLinesReporter::assertionFailed(const Failure& failure)
+	{
+		out << "{\"event\":\"assertion_failed\",\"path\":" << Json{ failure.path }
+			<< ",\"file\":" << Json{ failure.file }
+			<< ",\"line\":" << failure.line
+			<< ",\"expr\":" << Json{ failure.expr }
+			<< ",\"count\":" << failure.count
+			<< ",\"message\":" << Json{ failure.message } << "}\n";
+	}
+	void JsonLinesReporter::exceptionThrown(const Failure& failure)
+	{
+		out << "{\"event\":\"exception_thrown\",\"path\":" << Json{ failure.path }
+			<< ",\"count\":" << failure.count
+			<< ",\"message\":" << Json{ failure.message } << "}\n";
+	}
+	void JsonLinesReporter::benchmarkDone(const BenchmarkStats& stats)
+	{
+		out << "{\"event\":\"benchmark_done\",\"name\":" << Json{ stats.name }
+			<< ",\"iterations\":" << stats.iterations
+			<< ",\"samples\":" << stats.samples
+			<< ",\"min\":" << JsonNumber{ stats.min }
+			<< ",\"median\":" << JsonNumber{ stats.median }
+			<< ",\"mean\":" << JsonNumber{ stats.mean }
+			<< ",\"mad\":" << JsonNumber{ stats.mad }
+			<< ",\"stddev\":" << JsonNumber{ stats.stddev };
+		if (stats.max > 0)
+			out << ",\"p90\":" << JsonNumber{ stats.p90 }
+				<< ",\"p99\":" << JsonNumber{ stats.p99 }
+				<< ",\"p999\":" << JsonNumber{ stats.p999 }
+				<< ",\"max\":" << JsonNumber{ stats.max };
+		out << "}\n";
+	}
+	void JsonLinesReporter::fixtureSetUp(std::string_view name, const Timing& timing)
+	{
+		out << "{\"event\":\"fixture_set_up\",\"name\":" << Json{ name } << JsonTiming{ timing } << "}\n";
+	}
+	void JsonLinesReporter::subcaseDone(const SubcaseInfo& info)
+	{
+		out << "{\"event\":\"subcase_done\",\"path\":" << Json{ info.id }
+			<< ",\"asserts\":" << info.assert_count
+			<< ",\"failures\":" << info.fail_count
+			<< ",\"exceptions\":" << info.exception_count
+			<< JsonTiming{ info.timing }
+			<< JsonAllocations{ info.allocations } << "}\n";
+	}
+	void JsonLinesReporter::caseDone(std::string_view name, const TestResults& results)
+	{
+		out << "{\"event\":\"case_done\",\"name\":" << Json{ name }
+			<< ",\"subcases\":" << results.subcase_count
+			<< ",\"asserts\":" << results.assert_count
+			<< ",\"failures\":" << results.fail_count
+			<< ",\"exceptions\":" << results.exception_count
+			<< JsonTiming{ results.timing }
+			<< JsonAllocations{ results.allocations } << "}\n";
+		out.flush();
+	}
+	void JsonLinesReporter::runDone(const TestResults& results, size_t case_count, double seconds)
+	{
+		out << "{\"event\":\"run_done\",\"seconds\":" << JsonNumber{ seconds }
+			<< ",\"cases\":" << case_count
+			<< ",\"subcases\":" << results.subcase_count
+			<< ",\"asserts\":" << results.assert_count
+			<< ",\"failures\":" << results.fail_count
+			<< ",\"exceptions\":" << results.exception_count
+			<< ",\"benchmarks\":" << results.benchmark_count << "}\n";
+		out.flush();
+	}
+
+
+	std::shared_ptr<Reporter> makeReporter(std::string_view kind, std::unique_ptr<std::ostream> out)
+	{
+		if (kind == "text")
+			return std::make_shared<TextReporter>(std::move(out));
+		if (kind == "junit")
+			return std::make_shared<JUnitReporter>(std::move(out));
+		if (kind == "jsonl")
+			return std::make_shared<JsonLinesReporter>(std::move(out));
+		throw std::invalid_argument("unknown reporter " + std::string(kind));
+	}
+}
@@ -0,0 +1,150 @@
+// Example cases for tests/run.sh, which runs them in each mode and compares the reported events
+// Their failures are deliberate and must not depend on timing, thread scheduling or the mode
+#include "tester_with_macros.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_CASE("subcases", "[basic]")
+{
+	int value = 1;
+	CHECK(value == 1);
+	tester::Subcase("equal") << [&] { CHECK(value == 2); };
+	tester::Subcase("nested") << [&]
+	{
+		tester::Subcase("less") << [&] { CHECK(value < 0); };
+		tester::Subcase("passes") << [&] { CHECK(value > 0); };
+	};
+	tester::Subcase("repeat") << [&] { tester::Repeat(10) << [&] { CHECK(value != 1); }; };
+	tester::Subcase("parallel repeat") << [&] { tester::Repeat(100).parallel(4) << [&] { CHECK(value == 3); }; };
+	std::vector<int> a = { 1, 2, 3 }, b = { 1, 5, 3 };
+	CHECK_EACH(a == b);
+	CHECK_APPROX(1.0 == 1.5);
+};
+
+TEST_CASE("exception", "[basic]")
+{
+	CHECK(true);
+	tester::Subcase("throws") << [] { throw std::runtime_error("thrown on purpose"); };
+	tester::Subcase("after") << [] { CHECK(1 == 2); };
+};
+
+TEST_CASE("adopt", "[threads]")
+{
+	std::thread thread([context = tester::context()]
+	{
+		tester::Adopt adopt(context);
+		CHECK(1 == 1);
+		CHECK(2 == 3);
+	});
+	thread.join();
+};
+
+TEST_CASE("property", "[property]")
+{
+	PROPERTY("below 100", tester::integers<int>(-1000, 1000))(int a) { CHECK(a < 100); };
+	PROPERTY("no x", tester::strings())(const std::string& s) { CHECK(s.find('x') == std::string::npos); };
+};
+
+static tester::Fixture<std::vector<int>> table("table", [] { return std::vector<int>(100, 1); });
+
+TEST_CASE("fixture first", "[table]")
+{
+	CHECK(table->size() == 100u);
+	CHECK(table->front() == 2);
+};
+
+TEST_CASE("fixture second", "[table]")
+{
+	CHECK(table->back() == 1);
+};
+
+TEST_CASE("hang", "[timeout]")
+{
+	tester::Subcase("outer") << []
+	{
+		CHECK(1 == 1);
+		tester::Subcase("inner") << [] { std::this_thread::sleep_for(std::chrono::seconds(100)); };
+	};
+};
+
+TEST_CASE("crash", "[crash]")
+{
+	tester::Subcase("before") << [] { CHECK(1 == 2); };
+	tester::Subcase("segfault") << [] { volatile int* p = nullptr; *p = 1; };
+	tester::Subcase("after") << [] { CHECK(3 == 4); };
+};
+
+static int fibonacci(int n)
+{
+	return n < 2 ? n : fibonacci(n - 1) + fibonacci(n - 2);
+}
+
+TEST_CASE("perf", "[perf]")
+{
+	// TESTER_SLOW stands for a regression against the recorded baseline
+	const int n = std::getenv("TESTER_SLOW") ? 22 : 16;
+	CHECK_PERF("fibonacci", tester::DoNotOptimize(fibonacci(n)));
+};
+
+TEST_CASE("buffers", "[buffers]")
+{
+	// Long enough to be compared in blocks, with more runs of mismatches than are printed, one across a block boundary
+	std::vector<int> a(3000, 1), b = a;
+	for (size_t i = 0; i < 15; ++i)
+		b[100 + 150 * i] = 2;
+	b[255] = b[256] = b[257] = 0;
+	b[2999] = 3;
+	CHECK_EACH(a == b);
+	CHECK_EACH(a == a);
+	std::vector<float> x(3000, 1.0f), y = x;
+	y[10] = 1.0f + 1e-7f;
+	y[1000] = 1.5f;
+	y[2000] = -1.0f;
+	y[2500] = 0.0f;
+	tester::presicion = tester::default_float_presicion;
+	CHECK_EACH_APPROX(x == y);
+};
+
+TEST_CASE("allocations", "[alloc]")
+{
+	int value = 0;
+	CHECK_NO_ALLOC(value += 1);
+	CHECK_NO_ALLOC(tester::Repeat(100) << [&] { tester::Subcase("inner") << [&] { value += 1; }; });
+	CHECK_NO_ALLOC(tester::DoNotOptimize(std::vector<int>(10)));
+	{
+		NO_ALLOC_SCOPE();
+		tester::DoNotOptimize(std::string(100, 'x'));
+	}
+	CHECK(value == 101);
+};
+
+BENCHMARK("fibonacci benchmark", "[benchmark]")
+{
+	tester::DoNotOptimize(fibonacci(10));
+};
+
+TEST_CASE("benchmarks", "[benchmark]")
+{
+	for (int n : { 5, 10 })
+		tester::Subcase("n=" + std::to_string(n)) << [&] { tester::Benchmark("fibonacci", 5) << [&] { tester::DoNotOptimize(fibonacci(n)); }; };
+};
+
+TEST_CASE("latency", "[latency]")
+{
+	tester::Latency latency("fibonacci", 1000);
+	latency << [] { tester::DoNotOptimize(fibonacci(10)); };
+	CHECK_PERCENTILE_BELOW(latency, 99, std::chrono::seconds(1));
+	// No iteration takes no time at all
+	CHECK_PERCENTILE_BELOW(latency, 50, std::chrono::seconds(0));
+};
+
+int main(int argc, char* argv[])
+{
+	tester::runTests(tester::parseArguments(argc, argv));
+	std::cout << tester::report.str();
+}
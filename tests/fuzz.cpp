@@ -0,0 +1,39 @@
+// Feeds each argument to a FUZZ_CASE through tester::fuzzOne, as src/tester_fuzz.cpp does for a fuzzer,
+// or given options runs it over a corpus through tester::runTests
+// A failed assertion aborts, which is how the fuzzer sees it as a crash
+#include "tester_with_macros.h"
+
+#include <cstdio>
+#include <cstring>
+
+static int body_runs = 0, first_runs = 0, second_runs = 0, other_runs = 0;
+
+FUZZ_CASE("nested")
+{
+	body_runs += 1;
+	tester::Subcase("outer") << [&]
+	{
+		tester::Subcase("first") << [&] { first_runs += 1; CHECK(input.size() < 8u); };
+		tester::Subcase("second") << [&]
+		{
+			second_runs += 1;
+			tester::Repeat(2) << [&] { CHECK(input.empty() || input[0] != 'x'); };
+		};
+	};
+	tester::Subcase("other") << [&] { other_runs += 1; };
+};
+
+int main(int argc, char* argv[])
+{
+	// Given options, the case runs over the files of --corpus like any other case
+	if (argc > 1 && argv[1][0] == '-')
+	{
+		tester::runTests(tester::parseArguments(argc, argv));
+		std::fputs(tester::report.str().c_str(), stdout);
+		std::printf("body ran %d times, first %d, second %d, other %d\n", body_runs, first_runs, second_runs, other_runs);
+		return 0;
+	}
+	for (int i = 1; i < argc; ++i)
+		tester::fuzzOne("nested", reinterpret_cast<const unsigned char*>(argv[i]), std::strlen(argv[i]));
+	std::printf("%d inputs, body ran %d times, first %d, second %d, other %d\n", argc - 1, body_runs, first_runs, second_runs, other_runs);
+}
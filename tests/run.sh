@@ -0,0 +1,168 @@
+#!/bin/sh
+# Runs the example cases of tests/cases.cpp, tests/slim_cases.cpp and tests/fuzz.cpp in each mode and compares what
+# the reporters write, without timings, with tests/expected
+# Usage: tests/run.sh [--update], with CXX and CXXFLAGS taken from the environment
+# --update rewrites each expected file from the first mode that uses it, and still compares the other modes with it
+set -e
+
+CXX=${CXX:-c++}
+CXXFLAGS=${CXXFLAGS:--std=c++17 -O1}
+TESTS=$(cd "$(dirname "$0")" && pwd)
+EXPECTED=$TESTS/expected
+UPDATE=0
+[ "$1" = --update ] && UPDATE=1
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+# Built from the tests directory, so failures name the files cases.cpp and slim_cases.cpp
+cd "$TESTS"
+$CXX $CXXFLAGS -pthread -I../include cases.cpp slim_cases.cpp ../src/tester.cpp ../src/tester_reporters.cpp -o "$WORK/cases"
+# Allocations are only tracked with tester_alloc.cpp linked, see the alloc modes
+$CXX $CXXFLAGS -pthread -I../include cases.cpp slim_cases.cpp ../src/tester.cpp ../src/tester_reporters.cpp ../src/tester_alloc.cpp -o "$WORK/cases-alloc"
+$CXX $CXXFLAGS -pthread -I../include fuzz.cpp ../src/tester.cpp ../src/tester_reporters.cpp -o "$WORK/fuzz"
+$CXX $CXXFLAGS ../tools/tester_trace.cpp -o "$WORK/tester_trace"
+
+FAILED=0
+
+compare()
+{
+	if [ $UPDATE = 1 ] && [ ! -e "$WORK/updated.$2" ]; then
+		cp "$3" "$EXPECTED/$2"
+		touch "$WORK/updated.$2"
+	fi
+	if diff -u "$EXPECTED/$2" "$3" > "$WORK/diff"; then
+		echo "$1: ok"
+	else
+		echo "$1: FAILED"
+		cat "$WORK/diff"
+		FAILED=1
+	fi
+}
+
+# Drops timings and statistics, but keeps the order of the events, which is the order of the cases in every mode
+normalize()
+{
+	sed -E \
+		-e 's/,"(wall|cpu|cycles|instructions|cache_misses|branch_misses|allocations|allocated_bytes|peak_bytes|seconds)":[^,}]*//g' \
+		-e 's/,"(iterations|samples|min|median|mean|mad|stddev|p90|p99|p999|max)":[^,}]*//g' \
+		-e 's/(timed out after )[0-9.e+-]+s/\1Ns/' \
+		-e 's/(slower than baseline)[^"]*/\1/' \
+		-e 's/(failed: p[0-9.]+ is )[^,]*/\1N/' \
+		-e 's/( samples  p50 )[^"]*/\1N/'
+}
+
+# events <mode> <expected file> <options...>: the JSON Lines events of a run of CASES, its exit status left in STATUS
+CASES=$WORK/cases
+events()
+{
+	mode=$1
+	expected=$2
+	shift 2
+	STATUS=0
+	"$CASES" --seed 1 --reporter jsonl "$@" > "$WORK/events" || STATUS=$?
+	normalize < "$WORK/events" > "$WORK/$mode.jsonl"
+	compare "$mode" "$expected" "$WORK/$mode.jsonl"
+}
+
+# counts <mode> <options...>: the assertion counts of a trace
+counts()
+{
+	mode=$1
+	shift
+	rm -f "$WORK/trace"
+	"$WORK/cases" --seed 1 --trace "$WORK/trace" "$@" > /dev/null
+	"$WORK/tester_trace" counts "$WORK/trace" > "$WORK/$mode.txt"
+	compare "$mode" trace.txt "$WORK/$mode.txt"
+}
+
+BASIC="--tag ~timeout --tag ~crash --tag ~perf --tag ~buffers --tag ~alloc --tag ~benchmark --tag ~latency"
+
+"$WORK/cases" --list > "$WORK/list.txt"
+compare list list.txt "$WORK/list.txt"
+
+"$WORK/cases" --seed 1 $BASIC --reporter text --slowest 0 | sed -E -e '/^tests done in /d' -e '/^        wall /d' > "$WORK/text.txt"
+compare text text.txt "$WORK/text.txt"
+
+"$WORK/cases" --seed 1 $BASIC --reporter junit | sed -E 's/ time="[^"]*"//g' > "$WORK/junit.xml"
+compare junit junit.xml "$WORK/junit.xml"
+
+events serial cases.jsonl $BASIC
+events threads cases.jsonl $BASIC --threads 4
+events fork-subcases cases.jsonl $BASIC --fork-subcases
+# Each worker process sets up the fixtures its cases use, so compare the first set up event of each
+"$WORK/cases" --seed 1 --reporter jsonl $BASIC --processes 2 | normalize | awk '!/"fixture_set_up"/ || !seen[$0]++' > "$WORK/processes.jsonl"
+compare processes cases.jsonl "$WORK/processes.jsonl"
+
+# Cases and subcases selected by name, and shards that together list every case once
+events select-case select-case.jsonl --case "fixture*" --case slim
+events select-subcase select-subcase.jsonl --case subcases --subcase "subcases/nested" --subcase "subcases/repeat"
+for shard in 0/3 1/3 2/3; do
+	echo "shard $shard"
+	"$WORK/cases" --list --shard $shard
+done > "$WORK/shards.txt"
+compare shards shards.txt "$WORK/shards.txt"
+
+# Failed cases first, then the ones without an entry, then the rest, longest first, each recorded again after the run
+printf '%s\n' '1 0 slim' '3 0 exception' '2 1 fixture second' > "$WORK/timing-db"
+"$WORK/cases" --seed 1 --reporter jsonl $BASIC --timing-db "$WORK/timing-db" | sed -n -E 's/^\{"event":"case_started","name":"(.*)"\}$/\1/p' > "$WORK/timing-db.txt"
+sed 's/^[^ ]* //' "$WORK/timing-db" | sort >> "$WORK/timing-db.txt"
+compare timing-db timing-db.txt "$WORK/timing-db.txt"
+
+# Ranges long enough to be compared in blocks, with more mismatches than are printed
+events buffers buffers.jsonl --tag buffers
+events buffers-threads buffers.jsonl --tag buffers --threads 2
+events mismatch-limit mismatch-limit.jsonl --tag buffers --mismatch-limit 2
+
+# Without tester_alloc.cpp the allocation checks pass
+CASES=$WORK/cases-alloc
+events alloc alloc.jsonl --tag alloc
+CASES=$WORK/cases
+events alloc-untracked alloc-untracked.jsonl --tag alloc
+
+# Only the names of the measurements are compared, and the failure of a percentile that cannot be met
+events benchmark benchmark.jsonl --tag benchmark
+events latency latency.jsonl --tag latency
+
+events crash-fork-subcases crash.jsonl --tag crash --fork-subcases
+events crash-processes crash-processes.jsonl --tag crash --processes 2
+
+events timeout timeout.jsonl --tag timeout --timeout 0.5
+if [ $STATUS != 124 ]; then
+	echo "timeout: FAILED, exit status $STATUS instead of 124"
+	FAILED=1
+fi
+events timeout-processes timeout.jsonl --tag timeout --timeout 0.5 --processes 2
+
+# Recorded first, then compared with a body that does about 20 times the work
+events perf-record perf-record.jsonl --tag perf --perf-baseline "$WORK/baseline"
+# The unchanged body is allowed some noise, the slower one is far beyond it
+events perf-same perf-record.jsonl --tag perf --perf-baseline "$WORK/baseline" --perf-tolerance 0.5
+export TESTER_SLOW=1
+events perf-slower perf-slower.jsonl --tag perf --perf-baseline "$WORK/baseline"
+unset TESTER_SLOW
+
+# Not with --fork-subcases, where the processes that skip a subcase run the code after it without reporting it
+counts trace $BASIC
+counts trace-threads $BASIC --threads 4
+counts trace-processes $BASIC --processes 2
+
+# Each input runs every subcase of the fuzz case, and a failure on any level aborts
+"$WORK/fuzz" ab cd > "$WORK/fuzz.txt"
+compare fuzz fuzz.txt "$WORK/fuzz.txt"
+# In a list, which set -e does not stop at, and in subshells, which keep the message of the shell about the abort
+# out of the output
+STATUS=$( ( ("$WORK/fuzz" ab xy > /dev/null 2> "$WORK/fuzz-failed.txt") && echo 0 || echo $?) 2> /dev/null )
+if [ $STATUS = 0 ]; then
+	echo "fuzz-failed: FAILED, a failed assertion did not abort"
+	FAILED=1
+fi
+compare fuzz-failed fuzz-failed.txt "$WORK/fuzz-failed.txt"
+# A file per input, named so they run in this order
+mkdir -p "$WORK/corpus/nested"
+printf ab > "$WORK/corpus/nested/1"
+printf xy > "$WORK/corpus/nested/2"
+printf 123456789 > "$WORK/corpus/nested/3"
+"$WORK/fuzz" --seed 1 --reporter jsonl --corpus "$WORK/corpus" | normalize > "$WORK/fuzz-corpus.jsonl"
+compare fuzz-corpus fuzz-corpus.jsonl "$WORK/fuzz-corpus.jsonl"
+
+exit $FAILED
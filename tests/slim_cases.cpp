@@ -0,0 +1,11 @@
+// A case defined with the slim header, which lands in the same case table as the others
+#include "tester_slim_with_macros.h"
+
+TEST_CASE("slim", "[basic]")
+{
+	int a = 1;
+	double d = 0.5;
+	CHECK(a == 2);
+	CHECK(a == 1 && d > 1);
+	tester::Subcase("sub") << [&] { CHECK(d < 0.25); };
+};
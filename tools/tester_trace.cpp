@@ -0,0 +1,289 @@
+// Decodes assertion traces written with RunOptions::trace (--trace path)
+// Build: g++ -std=c++17 -O2 tools/tester_trace.cpp -o tester_trace
+//
+// tester_trace counts trace           hits and failures per assertion site
+// tester_trace timeline trace [text]  events in time order, optionally only sites or paths containing text
+// tester_trace diff before after      sites whose counts differ, and where each path first ran differently
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+#include <algorithm>
+
+namespace
+{
+	constexpr uint32_t trace_magic = 0x45435254;
+	constexpr uint32_t trace_failed = 0x80000000u;
+
+	struct Site
+	{
+		std::string file;
+		uint32_t line = 0;
+		std::string expr;
+
+		bool operator<(const Site& other) const { return std::tie(file, line, expr) < std::tie(other.file, other.line, other.expr); }
+		bool operator==(const Site& other) const { return file == other.file && line == other.line && expr == other.expr; }
+	};
+	struct Event
+	{
+		uint64_t nanoseconds;
+		uint32_t pid;
+		uint32_t thread;
+		// Ids into Trace::sites and Trace::paths, unique for the whole trace
+		uint32_t site;
+		uint32_t path;
+		bool failed;
+	};
+	struct Trace
+	{
+		std::vector<Site> sites;
+		std::vector<std::string> paths;
+		std::vector<Event> events;
+	};
+
+	class Reader
+	{
+		std::string_view _data;
+	public:
+		Reader(std::string_view data) : _data(data) { }
+
+		bool empty() const { return _data.empty(); }
+
+		template <class T>
+		bool get(T& value)
+		{
+			if (_data.size() < sizeof(T))
+				return false;
+			std::memcpy(&value, _data.data(), sizeof(T));
+			_data.remove_prefix(sizeof(T));
+			return true;
+		}
+		bool get(std::string& text)
+		{
+			uint32_t size;
+			if (!get(size) || _data.size() < size)
+				return false;
+			text.assign(_data.substr(0, size));
+			_data.remove_prefix(size);
+			return true;
+		}
+		std::string_view take(size_t size)
+		{
+			const auto taken = _data.substr(0, size);
+			_data.remove_prefix(taken.size());
+			return taken;
+		}
+	};
+
+	bool load(const char* path, Trace& trace)
+	{
+		std::ifstream in(path, std::ios::binary);
+		if (!in)
+		{
+			std::cerr << "could not open " << path << '\n';
+			return false;
+		}
+		const std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+		std::map<Site, uint32_t> site_ids;
+		std::map<std::string, uint32_t> path_ids;
+		Reader file(data);
+		while (!file.empty())
+		{
+			uint32_t magic, size;
+			if (!file.get(magic) || magic != trace_magic || !file.get(size))
+			{
+				std::cerr << path << ": not a trace, or truncated\n";
+				return false;
+			}
+			Reader chunk(file.take(size));
+			auto corrupt = [&]
+			{
+				std::cerr << path << ": corrupt chunk\n";
+				return false;
+			};
+			uint32_t pid, thread, count;
+			if (!chunk.get(pid) || !chunk.get(thread))
+				return corrupt();
+
+			// Chunk local ids are mapped to ids for the whole trace
+			std::vector<uint32_t> sites, paths;
+			if (!chunk.get(count))
+				return corrupt();
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				Site site;
+				if (!chunk.get(site.line) || !chunk.get(site.file) || !chunk.get(site.expr))
+					return corrupt();
+				auto [found, inserted] = site_ids.try_emplace(site, uint32_t(trace.sites.size()));
+				if (inserted)
+					trace.sites.push_back(site);
+				sites.push_back(found->second);
+			}
+			if (!chunk.get(count))
+				return corrupt();
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				std::string name;
+				if (!chunk.get(name))
+					return corrupt();
+				auto [found, inserted] = path_ids.try_emplace(name, uint32_t(trace.paths.size()));
+				if (inserted)
+					trace.paths.push_back(name);
+				paths.push_back(found->second);
+			}
+			if (!chunk.get(count))
+				return corrupt();
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				uint64_t nanoseconds;
+				uint32_t site = 0, path_flags = 0;
+				if (!chunk.get(nanoseconds) || !chunk.get(site) || !chunk.get(path_flags) ||
+					site >= sites.size() || (path_flags & ~trace_failed) >= paths.size())
+					return corrupt();
+				trace.events.push_back({ nanoseconds, pid, thread, sites[site], paths[path_flags & ~trace_failed], (path_flags & trace_failed) != 0 });
+			}
+		}
+		std::stable_sort(trace.events.begin(), trace.events.end(), [](auto& a, auto& b) { return a.nanoseconds < b.nanoseconds; });
+		return true;
+	}
+
+	std::ostream& operator<<(std::ostream& out, const Site& site)
+	{
+		return out << site.file << '(' << site.line << ")  " << site.expr;
+	}
+
+	struct Count
+	{
+		size_t hits = 0;
+		size_t fails = 0;
+	};
+	std::map<Site, Count> count_sites(const Trace& trace)
+	{
+		std::map<Site, Count> counts;
+		for (auto& event : trace.events)
+		{
+			auto& count = counts[trace.sites[event.site]];
+			count.hits += 1;
+			count.fails += event.failed;
+		}
+		return counts;
+	}
+
+	int counts(const Trace& trace)
+	{
+		const auto counts = count_sites(trace);
+		std::vector<std::pair<Site, Count>> sorted(counts.begin(), counts.end());
+		std::stable_sort(sorted.begin(), sorted.end(), [](auto& a, auto& b) { return a.second.hits > b.second.hits; });
+		std::printf("%12s %8s  site\n", "hits", "fails");
+		for (auto& [site, count] : sorted)
+		{
+			std::printf("%12zu %8zu  ", count.hits, count.fails);
+			std::cout << site << '\n';
+		}
+		return 0;
+	}
+
+	int timeline(const Trace& trace, std::string_view filter)
+	{
+		if (trace.events.empty())
+			return 0;
+		const auto start = trace.events.front().nanoseconds;
+		for (auto& event : trace.events)
+		{
+			auto& site = trace.sites[event.site];
+			auto& path = trace.paths[event.path];
+			if (!filter.empty() && path.find(filter) == std::string::npos &&
+				site.file.find(filter) == std::string::npos && site.expr.find(filter) == std::string::npos)
+				continue;
+			std::printf("%14.3fus %6u:%-3u %s ", double(event.nanoseconds - start) / 1e3, event.pid, event.thread, event.failed ? "FAIL" : "pass");
+			std::cout << path << "  " << site << '\n';
+		}
+		return 0;
+	}
+
+	int diff(const Trace& before, const Trace& after)
+	{
+		int status = 0;
+		const auto a = count_sites(before);
+		const auto b = count_sites(after);
+		std::map<Site, std::pair<Count, Count>> both;
+		for (auto& [site, count] : a)
+			both[site].first = count;
+		for (auto& [site, count] : b)
+			both[site].second = count;
+		for (auto& [site, counts] : both)
+		{
+			auto& [x, y] = counts;
+			if (x.hits == y.hits && x.fails == y.fails)
+				continue;
+			status = 1;
+			std::printf("hits %zu -> %zu, fails %zu -> %zu  ", x.hits, y.hits, x.fails, y.fails);
+			std::cout << site << '\n';
+		}
+
+		// The order of sites within each path, across all processes and threads
+		auto sequences = [](const Trace& trace)
+		{
+			std::map<std::string, std::vector<std::pair<const Site*, bool>>> by_path;
+			for (auto& event : trace.events)
+				by_path[trace.paths[event.path]].emplace_back(&trace.sites[event.site], event.failed);
+			return by_path;
+		};
+		const auto x = sequences(before);
+		const auto y = sequences(after);
+		for (auto& [path, first] : x)
+		{
+			auto found = y.find(path);
+			if (found == y.end())
+			{
+				status = 1;
+				std::cout << path << ": only before\n";
+				continue;
+			}
+			auto& second = found->second;
+			const auto n = std::min(first.size(), second.size());
+			size_t i = 0;
+			while (i < n && *first[i].first == *second[i].first && first[i].second == second[i].second)
+				++i;
+			if (i == n && first.size() == second.size())
+				continue;
+			status = 1;
+			std::cout << path << ": diverges at assertion " << i << '\n';
+			if (i < first.size())
+				std::cout << "    before " << (first[i].second ? "FAIL " : "pass ") << *first[i].first << '\n';
+			if (i < second.size())
+				std::cout << "    after  " << (second[i].second ? "FAIL " : "pass ") << *second[i].first << '\n';
+		}
+		for (auto& [path, sequence] : y)
+			if (x.find(path) == x.end())
+			{
+				status = 1;
+				std::cout << path << ": only after\n";
+			}
+		return status;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const std::string_view command = argc > 1 ? argv[1] : "";
+	Trace first, second;
+	if (command == "counts" && argc == 3 && load(argv[2], first))
+		return counts(first);
+	if (command == "timeline" && (argc == 3 || argc == 4) && load(argv[2], first))
+		return timeline(first, argc == 4 ? argv[3] : "");
+	if (command == "diff" && argc == 4 && load(argv[2], first) && load(argv[3], second))
+		return diff(first, second);
+	std::cerr <<
+		"usage: tester_trace counts trace\n"
+		"       tester_trace timeline trace [text]\n"
+		"       tester_trace diff before after\n";
+	return 2;
+}